@@ -31,6 +31,23 @@ MYUM7SPI::MYUM7SPI(uint16_t cs_, uint32_t rate_) {
 	cs = cs_;
 	pinMode(cs, OUTPUT);
 	rate = rate_;
+
+	// Start the *_TIME monotonic checks from zero
+#if UM7_STORE_RAW
+	gyro_raw_time = accel_raw_time = mag_raw_time = temp_time = 0;
+#endif
+#if UM7_STORE_PROCESSED
+	gyro_time = accel_time = mag_time = 0;
+#endif
+#if UM7_STORE_EULER
+	euler_time = 0;
+#endif
+#if UM7_STORE_POSITION
+	pos_time = vel_time = 0;
+#endif
+
+	health = 0;
+	clear_errors();
 }
 
 // Useful for combining uint32_t with their composite bytes
@@ -138,122 +155,279 @@ void MYUM7SPI::set_misc_ssettings(bool pps, bool zg, bool q, bool mag) {
 
 	if (pps) b1 = 0b00000001;
 
-	if (zg) {
-		b0 = 00000100;
-		if (q) {
-			b0 = 00000110;
-			if (mag) b0 = 00000111;
-		}
-		if (mag) b0 = 00000101;
-	}
-	if (q) {
-		b0 = 00000010;
-		if (mag) b0 = 00000011;
-	}
-	if (mag) b0 = 00000001;
+	// Bit 2 = ZG, bit 1 = Q, bit 0 = MAG
+	if (zg) b0 |= 0b00000100;
+	if (q) b0 |= 0b00000010;
+	if (mag) b0 |= 0b00000001;
 
+	// write_register() sends bytes[3] first, so bytes[1] holds bits 15:8 (PPS is bit 8)
 	intval temp;
-	temp.bytes[0] = 0;
-	temp.bytes[1] = 0;
-	temp.bytes[2] = b1;
-	temp.bytes[3] = b0;
+	temp.bytes[0] = b0;
+	temp.bytes[1] = b1;
+	temp.bytes[2] = 0;
+	temp.bytes[3] = 0;
 
 	write_register(CREG_MISC_SETTINGS, temp.val);
 }
 
+// Writes all mag/accel calibration matrix and bias registers and reads every one back,
+// re-writing the ones that don't match up to UM7_MAX_REREADS times.
+// Only if all of them verify, and commit is set, they're saved to FLASH with a single flash_commit().
+// Returns false if any register didn't verify, nothing is committed then.
+bool MYUM7SPI::write_calibration(const um7_calibration_t& cal, bool commit) {
+	const float* values = (const float*)&cal;
+	uint32_t bits[UM7_CAL_REGISTERS];
+	bool ok = true;
+
+	memcpy(bits, values, sizeof(bits));
+	for (int i = 0; i < UM7_CAL_REGISTERS; i++) {
+		write_register(CREG_MAG_CAL1_1 + i, bits[i]);
+	}
+
+	for (int i = 0; i < UM7_CAL_REGISTERS; i++) {
+		byte address = CREG_MAG_CAL1_1 + i;
+		int tries = 0;
+		// Compare the bits, a NaN would never equal itself
+		float back = read_register(address);
+		while (memcmp(&back, &values[i], sizeof(float)) != 0 && tries++ < UM7_MAX_REREADS) {
+			write_register(address, bits[i]);
+			back = read_register(address);
+		}
+		if (memcmp(&back, &values[i], sizeof(float)) != 0) ok = false;
+	}
+
+	if (ok && commit) flash_commit();
+	return ok;
+}
+
+// Reads the calibration registers currently in use
+void MYUM7SPI::read_calibration(um7_calibration_t& cal) {
+	float* values = (float*)&cal;
+	for (int i = 0; i < UM7_CAL_REGISTERS; i++) {
+		values[i] = read_register(CREG_MAG_CAL1_1 + i);
+	}
+}
+
 //////////////////////////////
 //	DATA FUNCTIONS	    //
 //////////////////////////////
 
+#if UM7_STORE_RAW
 // Assigns all raw (gyro, accel, mag) data from the associated registers
 void MYUM7SPI::get_all_raw_data() {
+	sample_flags = 0;
+
 	gyro_raw_x = read_register(DREG_GYRO_RAW_XY, 1);
 	gyro_raw_y = read_register(DREG_GYRO_RAW_XY, 0);
 	gyro_raw_z = read_register(DREG_GYRO_RAW_Z, 1);
-	gyro_raw_time = read_register(DREG_GYRO_RAW_TIME);
+	gyro_raw_time = read_time(DREG_GYRO_RAW_TIME, gyro_raw_time);
 
 	accel_raw_x = read_register(DREG_ACCEL_RAW_XY, 1);
 	accel_raw_y = read_register(DREG_ACCEL_RAW_XY, 0);
 	accel_raw_z = read_register(DREG_ACCEL_RAW_Z, 1);
-	accel_raw_time = read_register(DREG_ACCEL_RAW_TIME);
+	accel_raw_time = read_time(DREG_ACCEL_RAW_TIME, accel_raw_time);
 
 	mag_raw_x = read_register(DREG_MAG_RAW_XY, 1);
 	mag_raw_y = read_register(DREG_MAG_RAW_XY, 0);
 	mag_raw_z = read_register(DREG_MAG_RAW_Z, 1);
-	mag_raw_time = read_register(DREG_MAG_RAW_TIME);
+	mag_raw_time = read_time(DREG_MAG_RAW_TIME, mag_raw_time);
 
 	temp = read_register(DREG_TEMPERATURE);
-	temp_time = read_register(DREG_TEMPERATURE_TIME);
+	temp_time = read_time(DREG_TEMPERATURE_TIME, temp_time);
+
+	publish_raw();
 }
+#endif
 
+#if UM7_STORE_PROCESSED
 // Assigns all processed (gyro, accel, mag) data from the associated registers
 void MYUM7SPI::get_all_processed_data() {
-	gyro_x = read_register(DREG_GYRO_PROC_X);
-	gyro_y = read_register(DREG_GYRO_PROC_Y);
-	gyro_z = read_register(DREG_GYRO_PROC_Z);
-	gyro_time = read_register(DREG_GYRO_PROC_TIME);
+	sample_flags = 0;
 
-	accel_x = read_register(DREG_ACCEL_PROC_X);
-	accel_y = read_register(DREG_ACCEL_PROC_Y);
-	accel_z = read_register(DREG_ACCEL_PROC_Z);
-	accel_time = read_register(DREG_ACCEL_PROC_TIME);
+	read_gyro_proc();
+	gyro_time = read_time(DREG_GYRO_PROC_TIME, gyro_time);
 
-	mag_x = read_register(DREG_MAG_PROC_X);
-	mag_y = read_register(DREG_MAG_PROC_Y);
-	mag_z = read_register(DREG_MAG_PROC_Z);
-	mag_time = read_register(DREG_MAG_PROC_TIME);
+	read_accel_proc();
+	accel_time = read_time(DREG_ACCEL_PROC_TIME, accel_time);
+
+	read_mag_proc();
+	mag_time = read_time(DREG_MAG_PROC_TIME, mag_time);
+
+	publish_processed();
 }
+#endif
 
+#if UM7_STORE_QUAT && UM7_STORE_EULER && UM7_STORE_POSITION
 // Assigns all orientation data from the associated registers
 void MYUM7SPI::get_all_orientation_data() {
-	quat_a = read_register(DREG_QUAT_AB, 1) / 29789.09091;
-	quat_b = read_register(DREG_QUAT_AB, 0) / 29789.09091;
-	quat_c = read_register(DREG_QUAT_CD, 1) / 29789.09091;
-	quat_d = read_register(DREG_QUAT_CD, 0) / 29789.09091;
+	sample_flags = 0;
+
+	quat_a = read_register(DREG_QUAT_AB, 1);
+	quat_b = read_register(DREG_QUAT_AB, 0);
+	quat_c = read_register(DREG_QUAT_CD, 1);
+	quat_d = read_register(DREG_QUAT_CD, 0);
 	quat_time = read_register(DREG_QUAT_TIME, 0);
 
-	roll = read_register(DREG_EULER_PHI_THETA, 1) / 91.02222;
-	pitch = read_register(DREG_EULER_PHI_THETA, 0) / 91.02222;
-	yaw = read_register(DREG_EULER_PSI, 1) / 91.02222;
+	read_euler();
 	roll_rate = read_register(DREG_EULER_PHI_THETA_DOT, 1) / 16.0;
 	pitch_rate = read_register(DREG_EULER_PHI_THETA_DOT, 0) / 16.0;
 	yaw_rate = read_register(DREG_EULER_PSI_DOT, 1) / 16.0;
-	euler_time = read_register(DREG_EULER_TIME);
+	euler_time = read_time(DREG_EULER_TIME, euler_time);
 
 	north_pos = read_register(DREG_POSITION_N);
 	east_pos = read_register(DREG_POSITION_E);
 	up_pos = read_register(DREG_POSITION_UP);
-	pos_time = read_register(DREG_POSITION_TIME);
+	pos_time = read_time(DREG_POSITION_TIME, pos_time);
 
 	north_vel = read_register(DREG_VELOCITY_N);
 	east_vel = read_register(DREG_VELOCITY_E);
 	up_vel = read_register(DREG_VELOCITY_UP);
-	vel_time = read_register(DREG_VELOCITY_TIME);
+	vel_time = read_time(DREG_VELOCITY_TIME, vel_time);
+
+	publish_quat();
+	publish_euler();
 }
+#endif
 
-// Custom read function for Val's datasets
+#if UM7_STORE_PROCESSED && UM7_STORE_EULER
+// Custom read function for Val's datasets.
+// Reads no *_TIME registers, so UM7_ERR_TIME is never set here. The SD loggers time records with micros().
 void MYUM7SPI::get_vals_data() {
-	gyro_x = read_register(DREG_GYRO_PROC_X);
-	gyro_y = read_register(DREG_GYRO_PROC_Y);
-	gyro_z = read_register(DREG_GYRO_PROC_Z);
+	sample_flags = 0;
 
-	accel_x = read_register(DREG_ACCEL_PROC_X);
-	accel_y = read_register(DREG_ACCEL_PROC_Y);
-	accel_z = read_register(DREG_ACCEL_PROC_Z);
+	read_gyro_proc();
+	read_accel_proc();
+	read_euler();
 
-	roll = read_register(DREG_EULER_PHI_THETA, 1) / 91.02222;
-	pitch = read_register(DREG_EULER_PHI_THETA, 0) / 91.02222;
-	yaw = read_register(DREG_EULER_PSI, 1) / 91.02222;
+	publish_processed();
+	publish_euler();
 }
+#endif
 
+#if UM7_STORE_PROCESSED
 void MYUM7SPI::get_bens_data() {
-	gyro_x = read_register(DREG_GYRO_PROC_X);
-	gyro_y = read_register(DREG_GYRO_PROC_Y);
-	gyro_z = read_register(DREG_GYRO_PROC_Z);
+	sample_flags = 0;
+
+	read_gyro_proc();
+	read_accel_proc();
+
+	publish_processed();
+}
+#endif
+
+#if UM7_STORE_QUAT
+// Assigns the quaternion like get_all_orientation_data(), each register read in one transfer.
+// Used for the joint angle pipeline in UM7Joint.h
+void MYUM7SPI::get_quat_data() {
+	read_register(DREG_QUAT_AB, &quat_a, &quat_b);
+	read_register(DREG_QUAT_CD, &quat_c, &quat_d);
+
+	publish_quat();
+}
+#endif
+
+//////////////////////////////////
+//	SNAPSHOT FUNCTIONS	//
+//////////////////////////////////
+
+// The getters fill the public variables one register at a time, then publish the whole group
+// into a double-buffered seqlock (UM7Seqlock.h). snapshot() copies the latest published group
+// without blocking the getters.
+
+void MYUM7SPI::publish_raw() {
+#if UM7_SNAPSHOTS && UM7_STORE_RAW
+	um7_raw_t g;
+	g.gyro_x = gyro_raw_x; g.gyro_y = gyro_raw_y; g.gyro_z = gyro_raw_z;
+	g.accel_x = accel_raw_x; g.accel_y = accel_raw_y; g.accel_z = accel_raw_z;
+	g.mag_x = mag_raw_x; g.mag_y = mag_raw_y; g.mag_z = mag_raw_z;
+	g.temp = temp; g.temp_time = temp_time;
+	g.gyro_time = gyro_raw_time; g.accel_time = accel_raw_time; g.mag_time = mag_raw_time;
+	g.flags = sample_flags;
+	raw_lock.write(g);
+#endif
+}
+
+void MYUM7SPI::publish_processed() {
+#if UM7_SNAPSHOTS && UM7_STORE_PROCESSED
+	um7_processed_t g;
+	g.gyro_x = gyro_x; g.gyro_y = gyro_y; g.gyro_z = gyro_z; g.gyro_time = gyro_time;
+	g.accel_x = accel_x; g.accel_y = accel_y; g.accel_z = accel_z; g.accel_time = accel_time;
+	g.mag_x = mag_x; g.mag_y = mag_y; g.mag_z = mag_z; g.mag_time = mag_time;
+	g.flags = sample_flags;
+	processed_lock.write(g);
+#endif
+}
+
+void MYUM7SPI::publish_euler() {
+#if UM7_SNAPSHOTS && UM7_STORE_EULER
+	um7_euler_t g;
+	g.roll = roll; g.pitch = pitch; g.yaw = yaw;
+	g.roll_rate = roll_rate; g.pitch_rate = pitch_rate; g.yaw_rate = yaw_rate;
+	g.euler_time = euler_time;
+	g.flags = sample_flags;
+	euler_lock.write(g);
+#endif
+}
+
+void MYUM7SPI::publish_quat() {
+#if UM7_SNAPSHOTS && UM7_STORE_QUAT
+	um7_quat_t g;
+	g.quat_a = quat_a; g.quat_b = quat_b; g.quat_c = quat_c; g.quat_d = quat_d;
+	g.quat_time = quat_time;
+	quat_lock.write(g);
+#endif
+}
+
+#if UM7_SNAPSHOTS
+#if UM7_STORE_RAW
+uint32_t MYUM7SPI::snapshot(um7_raw_t& out) const {
+	return raw_lock.read(out);
+}
+#endif
+#if UM7_STORE_PROCESSED
+uint32_t MYUM7SPI::snapshot(um7_processed_t& out) const {
+	return processed_lock.read(out);
+}
+#endif
+#if UM7_STORE_EULER
+uint32_t MYUM7SPI::snapshot(um7_euler_t& out) const {
+	return euler_lock.read(out);
+}
+#endif
+#if UM7_STORE_QUAT
+uint32_t MYUM7SPI::snapshot(um7_quat_t& out) const {
+	return quat_lock.read(out);
+}
+#endif
+#endif
+
+//////////////////////////////////
+//	VALIDATION FUNCTIONS	//
+//////////////////////////////////
+
+// Reads DREG_HEALTH into health and flags UM7_ERR_HEALTH if any fault bit is set.
+// Costs one register read, so call it every few hundred samples rather than every sample.
+// Returns true if the sensor is healthy.
+bool MYUM7SPI::check_health() {
+	floatval result;
+	result.val = read_register(DREG_HEALTH);
+	memcpy(&health, result.bytes, 4);
+
+	if (health & UM7_HEALTH_FAULTS) {
+		count_errors(UM7_ERR_HEALTH);
+		sample_flags |= UM7_ERR_HEALTH;
+		return false;
+	}
+	return true;
+}
 
-	accel_x = read_register(DREG_ACCEL_PROC_X);
-	accel_y = read_register(DREG_ACCEL_PROC_Y);
-	accel_z = read_register(DREG_ACCEL_PROC_Z);
+// Resets the error counters and flags
+void MYUM7SPI::clear_errors() {
+	sample_flags = 0;
+	reread_count = 0;
+	for (int i = 0; i < UM7_ERR_CLASSES; i++) {
+		error_count[i] = 0;
+	}
 }
 
 //////////////////////////////////
@@ -306,15 +480,116 @@ void MYUM7SPI::reset_ekf() {
 //	INTERNAL FUNCTIONS	//
 //////////////////////////////////
 
+// Classifies a float register value. A single compare covers the good case,
+// NaN fails every comparison so it lands in the slow path with Inf and out of range values.
+static byte check_float(float v, float limit) {
+	if (fabsf(v) <= limit) return 0;
+	return isfinite(v) ? UM7_ERR_RANGE : UM7_ERR_NAN;
+}
+
+// Adds one to the counter of every class in err
+void MYUM7SPI::count_errors(byte err) {
+	for (int i = 0; i < UM7_ERR_CLASSES; i++) {
+		if (err & (1 << i)) error_count[i]++;
+	}
+}
+
+#if UM7_STORE_PROCESSED
+// Reads the processed gyro registers, re-reading them (and only them) while they fail validation
+void MYUM7SPI::read_gyro_proc() {
+	byte err;
+	for (byte tries = 0;; tries++) {
+		gyro_x = read_register(DREG_GYRO_PROC_X);
+		gyro_y = read_register(DREG_GYRO_PROC_Y);
+		gyro_z = read_register(DREG_GYRO_PROC_Z);
+		err = check_float(gyro_x, UM7_GYRO_LIMIT) | check_float(gyro_y, UM7_GYRO_LIMIT) | check_float(gyro_z, UM7_GYRO_LIMIT);
+		if (!err) return;
+		count_errors(err);
+		if (tries >= UM7_MAX_REREADS) break;
+		reread_count++;
+	}
+	sample_flags |= err;
+}
+
+// Reads the processed accel registers, re-reading them while they fail validation
+void MYUM7SPI::read_accel_proc() {
+	byte err;
+	for (byte tries = 0;; tries++) {
+		accel_x = read_register(DREG_ACCEL_PROC_X);
+		accel_y = read_register(DREG_ACCEL_PROC_Y);
+		accel_z = read_register(DREG_ACCEL_PROC_Z);
+		err = check_float(accel_x, UM7_ACCEL_LIMIT) | check_float(accel_y, UM7_ACCEL_LIMIT) | check_float(accel_z, UM7_ACCEL_LIMIT);
+		if (!err) return;
+		count_errors(err);
+		if (tries >= UM7_MAX_REREADS) break;
+		reread_count++;
+	}
+	sample_flags |= err;
+}
+
+// Reads the processed mag registers, re-reading them while they fail validation
+void MYUM7SPI::read_mag_proc() {
+	byte err;
+	for (byte tries = 0;; tries++) {
+		mag_x = read_register(DREG_MAG_PROC_X);
+		mag_y = read_register(DREG_MAG_PROC_Y);
+		mag_z = read_register(DREG_MAG_PROC_Z);
+		err = check_float(mag_x, UM7_MAG_LIMIT) | check_float(mag_y, UM7_MAG_LIMIT) | check_float(mag_z, UM7_MAG_LIMIT);
+		if (!err) return;
+		count_errors(err);
+		if (tries >= UM7_MAX_REREADS) break;
+		reread_count++;
+	}
+	sample_flags |= err;
+}
+#endif
+
+#if UM7_STORE_EULER
+// Reads the euler angle registers, re-reading them while they are outside +/-180 (roll, yaw) or +/-90 (pitch) degrees
+void MYUM7SPI::read_euler() {
+	byte err;
+	for (byte tries = 0;; tries++) {
+		roll = read_register(DREG_EULER_PHI_THETA, 1) / 91.02222;
+		pitch = read_register(DREG_EULER_PHI_THETA, 0) / 91.02222;
+		yaw = read_register(DREG_EULER_PSI, 1) / 91.02222;
+		err = (roll > 180 || roll < -180 || pitch > 90 || pitch < -90 || yaw > 180 || yaw < -180) ? UM7_ERR_RANGE : 0;
+		if (!err) return;
+		count_errors(err);
+		if (tries >= UM7_MAX_REREADS) break;
+		reread_count++;
+	}
+	sample_flags |= err;
+}
+#endif
+
+// Reads a *_TIME register, re-reading it while it's NaN/Inf or earlier than the last value
+float MYUM7SPI::read_time(byte address, float last) {
+	float t;
+	byte err;
+	for (byte tries = 0;; tries++) {
+		t = read_register(address);
+		err = check_float(t, 3.4e38f) & UM7_ERR_NAN;
+		if (!err && t < last) err = UM7_ERR_TIME;
+		if (!err) return t;
+		count_errors(err);
+		if (tries >= UM7_MAX_REREADS) break;
+		reread_count++;
+	}
+	sample_flags |= err;
+	return t;
+}
+
 // Read a register that carries 2 datasets (euler data). 
 // Uses a user defined bool to determine which dataset to return
 int16_t MYUM7SPI::read_register(byte address, bool first_half) {
+	UM7_TRACE_BEGIN(span);
 	SPI.beginTransaction(SPISettings(rate, MSBFIRST, SPI_MODE0));
 	
 	byte inByte = 0;
 	int16_t result;
 	
 	digitalWrite(cs, LOW);
+	UM7_TRACE_CS_LOW(span);
 	
 	SPI.transfer(READ);
 	delayMicroseconds(5);
@@ -340,18 +615,55 @@ int16_t MYUM7SPI::read_register(byte address, bool first_half) {
 	result = result | inByte;
 
 	digitalWrite(cs, HIGH);
-	return(result);
+	UM7_TRACE_CS_HIGH(span);
 	
 	SPI.endTransaction();
+	UM7_TRACE_END(span, UM7_TRACE_READ, cs, address, first_half ? 4 : 6);
+
+	return(result);
+}
+
+// Read both datasets of a 2 dataset register in a single transfer,
+// half the bus time of calling read_register(address, first_half) twice.
+void MYUM7SPI::read_register(byte address, int16_t* first, int16_t* second) {
+	UM7_TRACE_BEGIN(span);
+	SPI.beginTransaction(SPISettings(rate, MSBFIRST, SPI_MODE0));
+
+	byte b[4];
+
+	digitalWrite(cs, LOW);
+	UM7_TRACE_CS_LOW(span);
+
+	SPI.transfer(READ);
+	delayMicroseconds(5);
+
+	SPI.transfer(address);
+	delayMicroseconds(5);
+
+	for (int i = 0; i < 4; i++) {
+		b[i] = SPI.transfer(0x00);
+		delayMicroseconds(5);
+	}
+
+	digitalWrite(cs, HIGH);
+	UM7_TRACE_CS_HIGH(span);
+
+	SPI.endTransaction();
+	UM7_TRACE_END(span, UM7_TRACE_READ, cs, address, 6);
+
+	*first = (int16_t)((b[0] << 8) | b[1]);
+	*second = (int16_t)((b[2] << 8) | b[3]);
 }
 
 // Read from a register. Assume register takes an entire 4 Bytes and is a float point type.
 float MYUM7SPI::read_register(byte address) {
+	UM7_TRACE_BEGIN(span);
 	SPI.beginTransaction(SPISettings(rate, MSBFIRST, SPI_MODE0));
 	
 	floatval result;
 
 	digitalWrite(cs, LOW);
+	UM7_TRACE_CS_LOW(span);
 
 	SPI.transfer(READ);
 	delayMicroseconds(5);
@@ -368,9 +680,12 @@ float MYUM7SPI::read_register(byte address) {
 	}
 
 	digitalWrite(cs, HIGH);
-	return(result.val);
-	
+	UM7_TRACE_CS_HIGH(span);
+
 	SPI.endTransaction();
+	UM7_TRACE_END(span, UM7_TRACE_READ, cs, address, 6);
+
+	return(result.val);
 }
 
 // Used for the SD example in order to write binary data directly,
@@ -454,9 +769,11 @@ void MYUM7SPI::write_register(byte address, uint32_t contents_) {
 	intval contents;
 	contents.val = contents_;
 	
+	UM7_TRACE_BEGIN(span);
 	SPI.beginTransaction(SPISettings(rate, MSBFIRST, SPI_MODE0));
 	
 	digitalWrite(cs, LOW);
+	UM7_TRACE_CS_LOW(span);
 
 	SPI.transfer(WRITE);
 	delayMicroseconds(5);
@@ -470,17 +787,21 @@ void MYUM7SPI::write_register(byte address, uint32_t contents_) {
 	}
 
 	digitalWrite(cs, HIGH);
+	UM7_TRACE_CS_HIGH(span);
 	
 	SPI.endTransaction();
+	UM7_TRACE_END(span, UM7_TRACE_WRITE, cs, address, 6);
 }
 
 // Writes to a command register. Since no contents are required, 
 // the SPI bus passes 0x00 over the MOSI line.
 // This is an overloaded function with dual calls for command and configuration writes()
 void MYUM7SPI::write_register(byte address) {
+	UM7_TRACE_BEGIN(span);
 	SPI.beginTransaction(SPISettings(rate, MSBFIRST, SPI_MODE0));
 	
 	digitalWrite(cs, LOW);
+	UM7_TRACE_CS_LOW(span);
 
 	SPI.transfer(WRITE);
 	delayMicroseconds(5);
@@ -494,6 +815,8 @@ void MYUM7SPI::write_register(byte address) {
 	}
 
 	digitalWrite(cs, HIGH);
+	UM7_TRACE_CS_HIGH(span);
 	
 	SPI.endTransaction();
+	UM7_TRACE_END(span, UM7_TRACE_WRITE, cs, address, 6);
 }
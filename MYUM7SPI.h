@@ -133,6 +133,47 @@
 #define READ 0x00
 #define WRITE 0x01
 
+//////////////////////////////////
+//	SAMPLE VALIDATION	//
+//////////////////////////////////
+
+// Error classes, bits of sample_flags and indices of error_count[]
+#define UM7_ERR_NAN 0x01 // float register read as NaN or Inf
+#define UM7_ERR_RANGE 0x02 // value outside what the sensor can output
+// *_TIME register went backwards. Only the getters that read *_TIME registers (get_all_raw_data(),
+// get_all_processed_data(), get_all_orientation_data()) can set it. get_vals_data(), get_bens_data()
+// and get_quat_data() skip the time registers to save bus time, so their samples never get this check.
+#define UM7_ERR_TIME 0x04
+#define UM7_ERR_HEALTH 0x08 // fault bit set in DREG_HEALTH
+#define UM7_ERR_CLASSES 4
+
+// DREG_HEALTH bits
+#define UM7_HEALTH_OVF 0x0100 // UART buffer overflow
+#define UM7_HEALTH_MG_N 0x0020 // Mag norm out of range
+#define UM7_HEALTH_ACC_N 0x0010 // Accel norm out of range
+#define UM7_HEALTH_ACCEL 0x0008 // Accelerometer failed to initialize
+#define UM7_HEALTH_GYRO 0x0004 // Gyro failed to initialize
+#define UM7_HEALTH_MAG 0x0002 // Magnetometer failed to initialize
+#define UM7_HEALTH_GPS 0x0001 // No GPS packets received
+// GPS is optional, so it isn't treated as a fault
+#define UM7_HEALTH_FAULTS (UM7_HEALTH_OVF | UM7_HEALTH_MG_N | UM7_HEALTH_ACC_N | UM7_HEALTH_ACCEL | UM7_HEALTH_GYRO | UM7_HEALTH_MAG)
+
+// Limits for the range check, a little over the sensor's full scale
+#ifndef UM7_GYRO_LIMIT
+#define UM7_GYRO_LIMIT 2100.0f // deg/s
+#endif
+#ifndef UM7_ACCEL_LIMIT
+#define UM7_ACCEL_LIMIT 16.0f // G
+#endif
+#ifndef UM7_MAG_LIMIT
+#define UM7_MAG_LIMIT 100.0f // normalized
+#endif
+
+// Times a register group is read again after failing validation
+#ifndef UM7_MAX_REREADS
+#define UM7_MAX_REREADS 2
+#endif
+
 #if defined(ARDUINO) && ARDUINO >= 100
 #include "Arduino.h"
 #else
@@ -141,6 +182,51 @@
 
 #include <SPI.h>
 
+#include "MYUM7SPIConfig.h"
+#include "UM7Trace.h"
+
+// Magnetometer and accelerometer calibration in register order, CREG_MAG_CAL1_1 to CREG_ACCEL_BIAS_Z.
+// Matrices are row major. extras/host/um7_calibrate fits them to logged raw samples.
+struct um7_calibration_t {
+	float mag_cal[9];
+	float mag_bias[3];
+	float accel_cal[9];
+	float accel_bias[3];
+};
+#define UM7_CAL_REGISTERS 24
+
+#if UM7_SNAPSHOTS
+#include "UM7Seqlock.h"
+
+// Sample groups returned by snapshot(), each published whole at the end of a getter.
+// flags holds the sample_flags of the getter call that published it.
+struct um7_raw_t {
+	int16_t gyro_x, gyro_y, gyro_z;
+	int16_t accel_x, accel_y, accel_z;
+	int16_t mag_x, mag_y, mag_z;
+	float temp, temp_time;
+	float gyro_time, accel_time, mag_time;
+	byte flags;
+};
+
+struct um7_processed_t {
+	float gyro_x, gyro_y, gyro_z, gyro_time;
+	float accel_x, accel_y, accel_z, accel_time;
+	float mag_x, mag_y, mag_z, mag_time;
+	byte flags;
+};
+
+struct um7_euler_t {
+	int16_t roll, pitch, yaw, roll_rate, pitch_rate, yaw_rate;
+	float euler_time;
+	byte flags;
+};
+
+struct um7_quat_t {
+	int16_t quat_a, quat_b, quat_c, quat_d, quat_time;
+};
+#endif
+
 class MYUM7SPI {
 
 public:
@@ -159,22 +245,57 @@ public:
 	void set_orientation_rate(byte quat_rate);
 	void set_misc_ssettings(bool pps, bool zg, bool q, bool mag);
 
+	bool write_calibration(const um7_calibration_t& cal, bool commit);
+	void read_calibration(um7_calibration_t& cal);
+
 	//////////////////////////////
 	//	DATA FUNCTIONS      //
 	//////////////////////////////
 
+	// Only the getters whose channel groups are enabled in MYUM7SPIConfig.h exist
+#if UM7_STORE_RAW
 	void get_all_raw_data();
+#endif
+#if UM7_STORE_PROCESSED
 	void get_all_processed_data();
+	void get_bens_data();
+#endif
+#if UM7_STORE_QUAT && UM7_STORE_EULER && UM7_STORE_POSITION
 	void get_all_orientation_data();
+#endif
+#if UM7_STORE_PROCESSED && UM7_STORE_EULER
 	void get_vals_data();
-	void get_bens_data();
+#endif
+#if UM7_STORE_QUAT
+	void get_quat_data();
+#endif
 	void read_binary_data(byte address, byte b0, byte b1, byte b2, byte b3);
 	void read_binary_data(byte address, byte b0, byte b1, bool first_half);
 
+#if UM7_SNAPSHOTS
+	// Consistent copy of the latest published group, safe to call from another context than the getters.
+	// Returns the number of times the group was published, 0 if never.
+#if UM7_STORE_RAW
+	uint32_t snapshot(um7_raw_t& out) const;
+#endif
+#if UM7_STORE_PROCESSED
+	uint32_t snapshot(um7_processed_t& out) const;
+#endif
+#if UM7_STORE_EULER
+	uint32_t snapshot(um7_euler_t& out) const;
+#endif
+#if UM7_STORE_QUAT
+	uint32_t snapshot(um7_quat_t& out) const;
+#endif
+#endif
+
 	//////////////////////////////////
 	//	COMMAND FUNCTIONS	//
 	//////////////////////////////////
 	
+	bool check_health();
+	void clear_errors();
+
 	int32_t get_firmware();
 	void flash_commit();
 	void factory_reset();
@@ -188,29 +309,43 @@ public:
 	//	 ACCESSIBLE VARIABLES       //
 	//////////////////////////////////////
 
+	// Groups are selected in MYUM7SPIConfig.h
+
+#if UM7_STORE_EULER
 	// EULER Variables
 	int16_t roll, pitch, yaw, roll_rate, pitch_rate, yaw_rate;
 	float euler_time;
+#endif
 
+#if UM7_STORE_QUAT
 	// QUATERNION Variables
+	// Raw register counts from every getter, divide by 29789.09091 for a unit quaternion
 	int16_t quat_a, quat_b, quat_c, quat_d, quat_time;
+#endif
 
+#if UM7_STORE_RAW
 	// RAW Variables
 	int16_t gyro_raw_x, gyro_raw_y, gyro_raw_z;
 	int16_t accel_raw_x, accel_raw_y, accel_raw_z;
 	int16_t mag_raw_x, mag_raw_y, mag_raw_z;
 	float temp, temp_time;
 	float gyro_raw_time, accel_raw_time, mag_raw_time;
+#endif
 
+#if UM7_STORE_PROCESSED
 	// PROCESSED Variables
 	float gyro_x, gyro_y, gyro_z, gyro_time;
 	float accel_x, accel_y, accel_z, accel_time;
 	float mag_x, mag_y, mag_z, mag_time;
+#endif
 
+#if UM7_STORE_POSITION
 	// POSITION and VELOCITY Variables
 	float north_pos, east_pos, up_pos, pos_time;
 	float north_vel, east_vel, up_vel, vel_time;
+#endif
 
+#if UM7_STORE_GPS
 	// GPS Variables
 	// Only available if GPS is installed with coms set on TX2/RX2 
 	float lattitude, longitude, altitude, course, speed, gps_time;
@@ -220,10 +355,21 @@ public:
 	// SNR = Signal-to-Noise Ratio
 	// (Note index is 1 lower than actual satellite ID)
 	float satellite_id[12], satellite_SNR[12];
+#endif
 
+#if UM7_STORE_GYRO_BIAS
 	// GYRO BIAS Variables. 
 	// Not necessary to read in for ZERO_GYROS, that function already measures these
 	float gyro_bias_x, gyro_bias_y, gyro_bias_z;
+#endif
+
+	// VALIDATION Variables
+	// sample_flags holds the UM7_ERR_* classes still failing after the re-reads of the last getter call,
+	// error_count[] counts every failed check per class (bit index) and reread_count the group re-reads
+	byte sample_flags;
+	uint32_t error_count[UM7_ERR_CLASSES];
+	uint32_t reread_count;
+	uint32_t health;
 
 private:
 
@@ -232,11 +378,44 @@ private:
 	//////////////////////////////////
 
 	int16_t read_register(byte address, bool first_half);
+	void read_register(byte address, int16_t* first, int16_t* second);
 	float read_register(byte address);
 
 	void write_register(byte address, uint32_t contents_);
 	void write_register(byte address);
 
+#if UM7_STORE_PROCESSED
+	void read_gyro_proc();
+	void read_accel_proc();
+	void read_mag_proc();
+#endif
+#if UM7_STORE_EULER
+	void read_euler();
+#endif
+	float read_time(byte address, float last);
+	void count_errors(byte err);
+
+	// Copy a group into its seqlock, no-ops without UM7_SNAPSHOTS
+	void publish_raw();
+	void publish_processed();
+	void publish_euler();
+	void publish_quat();
+
+#if UM7_SNAPSHOTS
+#if UM7_STORE_RAW
+	UM7Seqlock<um7_raw_t> raw_lock;
+#endif
+#if UM7_STORE_PROCESSED
+	UM7Seqlock<um7_processed_t> processed_lock;
+#endif
+#if UM7_STORE_EULER
+	UM7Seqlock<um7_euler_t> euler_lock;
+#endif
+#if UM7_STORE_QUAT
+	UM7Seqlock<um7_quat_t> quat_lock;
+#endif
+#endif
+
 	int cs;
 	uint32_t rate; 
 };
@@ -0,0 +1,73 @@
+/*
+
+Compile-time configuration for the MYUM7SPI library.
+
+Every MYUM7SPI instance stores the channel groups enabled here. Set a group
+to 0 to drop its variables and getters from the class, e.g. three UM7s on a
+Teensy LC (8 KB RAM) logging get_vals_data() only need PROCESSED and EULER,
+which cuts each instance from ~310 to ~100 Bytes of RAM for the SD FIFO.
+
+Like SdFatConfig.h, edit the values in this file or set them as global build
+flags (-DUM7_STORE_GPS=0). Don't #define them in a sketch before including
+MYUM7SPI.h: the library's .cpp is compiled on its own and wouldn't see them.
+
+*/
+
+#ifndef MYUM7SPICONFIG_H
+#define MYUM7SPICONFIG_H
+
+// Raw gyro/accel/mag counts, temperature and their times. get_all_raw_data()
+#ifndef UM7_STORE_RAW
+#define UM7_STORE_RAW 1
+#endif
+
+// Processed gyro/accel/mag and their times.
+// get_all_processed_data(), get_bens_data(), and get_vals_data() with UM7_STORE_EULER
+#ifndef UM7_STORE_PROCESSED
+#define UM7_STORE_PROCESSED 1
+#endif
+
+// Euler angles, rates and time
+#ifndef UM7_STORE_EULER
+#define UM7_STORE_EULER 1
+#endif
+
+// Quaternion and time. get_quat_data(), needed by UM7Joint.h
+#ifndef UM7_STORE_QUAT
+#define UM7_STORE_QUAT 1
+#endif
+
+// Position and velocity. get_all_orientation_data() with UM7_STORE_EULER and UM7_STORE_QUAT
+#ifndef UM7_STORE_POSITION
+#define UM7_STORE_POSITION 1
+#endif
+
+// GPS and satellite variables, only used with a GPS on TX2/RX2
+#ifndef UM7_STORE_GPS
+#define UM7_STORE_GPS 1
+#endif
+
+// Gyro bias variables
+#ifndef UM7_STORE_GYRO_BIAS
+#define UM7_STORE_GYRO_BIAS 1
+#endif
+
+// Double-buffered copies of the RAW, PROCESSED, EULER and QUAT groups for snapshot(),
+// for reading samples from another context (ISR / main loop) without disabling interrupts.
+// Costs two copies of each enabled group per instance and a copy per getter call.
+#ifndef UM7_SNAPSHOTS
+#define UM7_SNAPSHOTS 0
+#endif
+
+// SPI transaction tracer (UM7Trace.h). Records every register read/write into a RAM
+// ring of UM7_TRACE_EVENTS (20 Bytes each) for profiling, compiled out when 0.
+#ifndef UM7_TRACE
+#define UM7_TRACE 0
+#endif
+// 64 events = 1280 Bytes of RAM, about 2 records of Teensy_DEDICATED_SPI_UM7 (27 reads each).
+// 512 (10KiB) keeps about 17 records, fine on Teensy 3.5/3.6/4.x.
+#ifndef UM7_TRACE_EVENTS
+#define UM7_TRACE_EVENTS 64
+#endif
+
+#endif
@@ -0,0 +1,95 @@
+/*
+
+Fixed point decimation filter for oversampled UM7 channels.
+
+A cascade of STAGES half-band FIR stages, each low-pass filtering and
+dropping every other sample, so one output comes out for every
+RATIO = 2^STAGES inputs. Sampling the UM7 RATIO times faster than the log
+rate and decimating keeps the record rate (and SD bandwidth) low without
+the aliasing of just polling less often.
+
+Each stage is the 11 tap Lagrange half-band
+
+  h = [3, 0, -25, 0, 150, 256, 150, 0, -25, 0, 3] / 512
+
+Every other tap is zero, and each stage only computes the samples it keeps
+(polyphase), so a stage costs 4 adds, 3 small multiplies and a shift per
+channel per output. Integer only, no FPU needed on the Teensy LC.
+Pass band is flat to ~0.1 of the input rate, -40 dB or better above 0.4.
+
+Samples are int32_t in any fixed scale (e.g. 0.01 deg/s). Keep |x| under
+2^21 so the sums can't overflow.
+
+Each stage delays by 5 of its input samples, the whole cascade by
+DELAY = 5 * (RATIO - 1) input samples.
+
+*/
+
+#ifndef UM7DECIMATOR_H
+#define UM7DECIMATOR_H
+
+#include <stdint.h>
+#include <string.h>
+
+template <uint8_t CHANNELS, uint8_t STAGES>
+class UM7Decimator {
+
+public:
+
+	static const uint16_t RATIO = 1 << STAGES;
+	static const uint16_t DELAY = 5 * (RATIO - 1);
+
+	UM7Decimator() { reset(); }
+
+	// Clears the history, the first outputs ramp up from 0
+	void reset() {
+		memset(hist, 0, sizeof(hist));
+		memset(pos, 0, sizeof(pos));
+		memset(phase, 0, sizeof(phase));
+	}
+
+	// Feeds one sample of every channel at the input rate.
+	// Returns true every RATIO calls, with the decimated sample in out.
+	bool push(const int32_t* in, int32_t* out) {
+		int32_t x[CHANNELS];
+		memcpy(x, in, sizeof(x));
+		for (uint8_t s = 0; s < STAGES; s++) {
+			uint8_t p = pos[s];
+			memcpy(hist[s][p], x, sizeof(x));
+			pos[s] = (p + 1) & (HIST - 1);
+			phase[s] ^= 1;
+			// Only every second input produces an output
+			if (phase[s]) return false;
+			filter(s, p, x);
+		}
+		memcpy(out, x, sizeof(x));
+		return true;
+	}
+
+private:
+
+	// History per stage, a power of two >= 11 taps
+	static const uint8_t HIST = 16;
+
+	// Output of stage s for the newest sample at history index p
+	void filter(uint8_t s, uint8_t p, int32_t* y) {
+		const int32_t* x0 = hist[s][p];
+		const int32_t* x2 = hist[s][(p - 2) & (HIST - 1)];
+		const int32_t* x4 = hist[s][(p - 4) & (HIST - 1)];
+		const int32_t* x5 = hist[s][(p - 5) & (HIST - 1)];
+		const int32_t* x6 = hist[s][(p - 6) & (HIST - 1)];
+		const int32_t* x8 = hist[s][(p - 8) & (HIST - 1)];
+		const int32_t* x10 = hist[s][(p - 10) & (HIST - 1)];
+		for (uint8_t c = 0; c < CHANNELS; c++) {
+			int32_t acc = 256 * x5[c] + 150 * (x4[c] + x6[c]) - 25 * (x2[c] + x8[c]) + 3 * (x0[c] + x10[c]);
+			// Rounds to nearest
+			y[c] = (acc + 256) >> 9;
+		}
+	}
+
+	int32_t hist[STAGES][HIST][CHANNELS];
+	uint8_t pos[STAGES];
+	uint8_t phase[STAGES];
+};
+
+#endif
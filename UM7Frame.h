@@ -0,0 +1,175 @@
+/*
+
+Binary sample frames for streaming UM7 data over USB serial.
+
+A frame carries one sample period of up to UM7_FRAME_MAX_IMUS sensors:
+
+ | VERSION | N_IMUS | SEQ | TIME | IMU_1 | ... | IMU_N | CRC |
+ |    8    |   8    | 16  |  32  |  240  |     |  240  |  16 |
+
+Every IMU block holds the same channels as get_vals_data(): gyro and accel
+as floats, roll/pitch/yaw as int16. Fields are little-endian, which is the
+native order for both the Teensy and x86 hosts.
+
+The payload plus CRC-16/CCITT is COBS encoded and terminated with a single
+0x00 byte, so a receiver can resynchronise on the next zero after any
+corrupted or dropped byte. The sequence number lets the receiver count
+dropped frames instead of shifting columns.
+
+This header has no Arduino dependencies so the host client shares it.
+
+*/
+
+#ifndef UM7FRAME_H
+#define UM7FRAME_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define UM7_FRAME_VERSION 1
+#define UM7_FRAME_MAX_IMUS 4
+#define UM7_FRAME_DELIM 0x00
+
+// Header = version + n_imus + seq + time
+#define UM7_FRAME_HEADER_SIZE 8
+// 6 floats + 3 int16
+#define UM7_FRAME_IMU_SIZE 30
+#define UM7_FRAME_CRC_SIZE 2
+
+// Largest unencoded payload (header + imus + crc)
+#define UM7_FRAME_MAX_PAYLOAD (UM7_FRAME_HEADER_SIZE + UM7_FRAME_MAX_IMUS * UM7_FRAME_IMU_SIZE + UM7_FRAME_CRC_SIZE)
+// COBS adds 1 byte per 254 plus the leading code byte, then the delimiter
+#define UM7_FRAME_MAX_ENCODED (UM7_FRAME_MAX_PAYLOAD + UM7_FRAME_MAX_PAYLOAD / 254 + 2)
+
+// One sensor's channels within a frame
+struct um7_frame_imu_t {
+	float gx, gy, gz;
+	float ax, ay, az;
+	int16_t roll, pitch, yaw;
+};
+
+// A decoded frame
+struct um7_frame_t {
+	uint16_t seq;
+	uint32_t t;
+	uint8_t n_imus;
+	um7_frame_imu_t imu[UM7_FRAME_MAX_IMUS];
+};
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF) using a nibble table,
+// small enough for the Teensy LC flash and still only 2 lookups per byte
+inline uint16_t um7_crc16(const uint8_t* data, size_t n) {
+	static const uint16_t table[16] = {
+		0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+		0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+	};
+	uint16_t crc = 0xFFFF;
+	for (size_t i = 0; i < n; i++) {
+		crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+		crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+	}
+	return crc;
+}
+
+// COBS encodes n bytes of "in" into "out" and appends the frame delimiter.
+// "out" must hold at least n + n/254 + 2 bytes. Returns the encoded length.
+inline size_t um7_cobs_encode(const uint8_t* in, size_t n, uint8_t* out) {
+	size_t code_i = 0, o = 1;
+	uint8_t code = 1;
+	for (size_t i = 0; i < n; i++) {
+		if (in[i] == 0) {
+			out[code_i] = code;
+			code_i = o++;
+			code = 1;
+		} else {
+			out[o++] = in[i];
+			if (++code == 0xFF) {
+				out[code_i] = code;
+				code_i = o++;
+				code = 1;
+			}
+		}
+	}
+	out[code_i] = code;
+	out[o++] = UM7_FRAME_DELIM;
+	return o;
+}
+
+// Decodes a COBS block (without its delimiter) into "out".
+// Returns the decoded length, or 0 if the block is malformed.
+inline size_t um7_cobs_decode(const uint8_t* in, size_t n, uint8_t* out) {
+	size_t i = 0, o = 0;
+	while (i < n) {
+		uint8_t code = in[i++];
+		if (code == 0 || i + code - 1 > n) return 0;
+		for (uint8_t k = 1; k < code; k++) out[o++] = in[i++];
+		if (code != 0xFF && i < n) out[o++] = 0;
+	}
+	return o;
+}
+
+// Serializes a frame and COBS encodes it into "out" (UM7_FRAME_MAX_ENCODED bytes).
+// Returns the number of bytes to send, delimiter included.
+inline size_t um7_frame_encode(const um7_frame_t& frame, uint8_t* out) {
+	uint8_t buf[UM7_FRAME_MAX_PAYLOAD];
+	uint8_t n_imus = frame.n_imus > UM7_FRAME_MAX_IMUS ? UM7_FRAME_MAX_IMUS : frame.n_imus;
+	size_t n = 0;
+
+	buf[n++] = UM7_FRAME_VERSION;
+	buf[n++] = n_imus;
+	memcpy(buf + n, &frame.seq, 2); n += 2;
+	memcpy(buf + n, &frame.t, 4); n += 4;
+	for (uint8_t i = 0; i < n_imus; i++) {
+		const um7_frame_imu_t& m = frame.imu[i];
+		memcpy(buf + n, &m.gx, 4); n += 4;
+		memcpy(buf + n, &m.gy, 4); n += 4;
+		memcpy(buf + n, &m.gz, 4); n += 4;
+		memcpy(buf + n, &m.ax, 4); n += 4;
+		memcpy(buf + n, &m.ay, 4); n += 4;
+		memcpy(buf + n, &m.az, 4); n += 4;
+		memcpy(buf + n, &m.roll, 2); n += 2;
+		memcpy(buf + n, &m.pitch, 2); n += 2;
+		memcpy(buf + n, &m.yaw, 2); n += 2;
+	}
+	uint16_t crc = um7_crc16(buf, n);
+	memcpy(buf + n, &crc, 2); n += 2;
+
+	return um7_cobs_encode(buf, n, out);
+}
+
+// Decodes one COBS block (delimiter stripped) into "frame".
+// Returns false on framing, length, version or CRC errors.
+inline bool um7_frame_decode(const uint8_t* in, size_t n, um7_frame_t& frame) {
+	uint8_t buf[UM7_FRAME_MAX_PAYLOAD + 2];
+	if (n > sizeof(buf)) return false;
+
+	size_t len = um7_cobs_decode(in, n, buf);
+	if (len < UM7_FRAME_HEADER_SIZE + UM7_FRAME_CRC_SIZE) return false;
+	if (buf[0] != UM7_FRAME_VERSION || buf[1] > UM7_FRAME_MAX_IMUS) return false;
+	if (len != UM7_FRAME_HEADER_SIZE + (size_t)buf[1] * UM7_FRAME_IMU_SIZE + UM7_FRAME_CRC_SIZE) return false;
+
+	uint16_t crc;
+	memcpy(&crc, buf + len - 2, 2);
+	if (crc != um7_crc16(buf, len - 2)) return false;
+
+	size_t p = 2;
+	frame.n_imus = buf[1];
+	memcpy(&frame.seq, buf + p, 2); p += 2;
+	memcpy(&frame.t, buf + p, 4); p += 4;
+	for (uint8_t i = 0; i < frame.n_imus; i++) {
+		um7_frame_imu_t& m = frame.imu[i];
+		memcpy(&m.gx, buf + p, 4); p += 4;
+		memcpy(&m.gy, buf + p, 4); p += 4;
+		memcpy(&m.gz, buf + p, 4); p += 4;
+		memcpy(&m.ax, buf + p, 4); p += 4;
+		memcpy(&m.ay, buf + p, 4); p += 4;
+		memcpy(&m.az, buf + p, 4); p += 4;
+		memcpy(&m.roll, buf + p, 2); p += 2;
+		memcpy(&m.pitch, buf + p, 2); p += 2;
+		memcpy(&m.yaw, buf + p, 2); p += 2;
+	}
+	return true;
+}
+
+#endif
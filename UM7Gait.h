@@ -0,0 +1,170 @@
+/*
+
+Real-time gait phase and event detection from the heel/toe FSRs and the
+shank UM7 gyro.
+
+An incremental state machine, constant work per sample (a few compares, no
+buffers or loops), so the time from a sample to its events is bounded:
+FSR events are published by the update() of the sample that caused them,
+MID_SWING one sample later (a peak is only known once the rate falls).
+
+ Phases:
+  SWING     neither FSR loaded
+  LOADING   heel only, after heel strike
+  FLAT      heel and toe
+  PUSH_OFF  toe only, after heel off
+
+ Events (bits returned by update()):
+  HEEL_STRIKE  first contact after a swing of at least min_swing_us
+  HEEL_OFF     heel unloaded while the toe is still loaded
+  TOE_OFF      both unloaded after a stance of at least min_stance_us
+  MID_SWING    peak of the shank sagittal rate during swing, above swing_dps
+
+FSR thresholds have hysteresis (on > off) so noise around the level can't
+chatter between phases. The minimum phase times reject bounces.
+
+No Arduino dependencies, so extras/host/um7_gait_bench.cpp runs the same
+code over logged sessions.
+
+*/
+
+#ifndef UM7GAIT_H
+#define UM7GAIT_H
+
+#include <stdint.h>
+
+#define UM7_GAIT_HEEL_STRIKE 0x01
+#define UM7_GAIT_HEEL_OFF 0x02
+#define UM7_GAIT_TOE_OFF 0x04
+#define UM7_GAIT_MID_SWING 0x08
+// Number of event kinds, event_t[] and event_count[] are indexed by bit number
+#define UM7_GAIT_EVENTS 4
+
+enum um7_gait_phase_t {
+	UM7_GAIT_SWING,
+	UM7_GAIT_LOADING,
+	UM7_GAIT_FLAT,
+	UM7_GAIT_PUSH_OFF
+};
+
+struct um7_gait_params_t {
+	uint16_t heel_on, heel_off; // FSR counts
+	uint16_t toe_on, toe_off;
+	float swing_dps;            // smallest mid-swing peak of the shank sagittal rate
+	uint32_t min_swing_us, min_stance_us;
+};
+
+// Defaults for a 12 bit FSR divider and a UM7 on the shank with x along the knee axis
+#define UM7_GAIT_DEFAULT_PARAMS { 400, 250, 400, 250, 100.0f, 200000, 200000 }
+
+class UM7Gait {
+
+public:
+
+	UM7Gait(const um7_gait_params_t& params_) : params(params_) { reset(); }
+
+	void reset() {
+		phase = UM7_GAIT_SWING;
+		heel_loaded = toe_loaded = false;
+		phase_start = 0;
+		started = false;
+		peak_armed = false;
+		peak_seen = false;
+		last_dps = 0;
+		last_t = 0;
+		for (int i = 0; i < UM7_GAIT_EVENTS; i++) {
+			event_t[i] = 0;
+			event_count[i] = 0;
+		}
+	}
+
+	// Feeds one sample: time in usec (wrapping is fine), FSR counts and the shank sagittal rate in deg/s,
+	// positive during swing (negate the gyro axis if the sensor is mounted the other way).
+	// Returns the UM7_GAIT_* events detected with this sample, their times are in event_t[].
+	uint8_t update(uint32_t t, uint16_t heel, uint16_t toe, float dps) {
+		uint8_t events = 0;
+
+		// Hysteresis on the FSRs
+		heel_loaded = heel_loaded ? heel > params.heel_off : heel >= params.heel_on;
+		toe_loaded = toe_loaded ? toe > params.toe_off : toe >= params.toe_on;
+		if (!started) {
+			// The first sample only sets the phase, there's no event to time yet
+			started = true;
+			phase_start = t;
+			phase = next_phase(UM7_GAIT_SWING);
+			last_t = t;
+			last_dps = dps;
+			return 0;
+		}
+
+		if (phase == UM7_GAIT_SWING) {
+			// First peak of the swing rate, the previous sample was the maximum
+			if (dps >= params.swing_dps && !peak_seen) peak_armed = true;
+			if (peak_armed && dps < last_dps) {
+				peak_armed = false;
+				peak_seen = true;
+				events |= publish(3, last_t);
+			}
+			if ((heel_loaded || toe_loaded) && t - phase_start >= params.min_swing_us) {
+				events |= publish(0, t);
+				set_phase(next_phase(phase), t);
+			}
+		} else if (!heel_loaded && !toe_loaded) {
+			if (t - phase_start >= params.min_stance_us) {
+				events |= publish(2, t);
+				peak_armed = false;
+				peak_seen = false;
+				set_phase(UM7_GAIT_SWING, t);
+			}
+		} else {
+			// Stance sub-phases, phase_start stays at heel strike.
+			// A toe first contact goes straight to PUSH_OFF from SWING, without a HEEL_OFF.
+			um7_gait_phase_t p = next_phase(phase);
+			if (p == UM7_GAIT_PUSH_OFF && phase != UM7_GAIT_PUSH_OFF) {
+				events |= publish(1, t);
+			}
+			phase = p;
+		}
+
+		last_t = t;
+		last_dps = dps;
+		return events;
+	}
+
+	um7_gait_params_t params;
+	um7_gait_phase_t phase;
+	// Time of the last event of each kind (index = bit number) and counts
+	uint32_t event_t[UM7_GAIT_EVENTS];
+	uint32_t event_count[UM7_GAIT_EVENTS];
+
+private:
+
+	// Phase from the FSRs. With neither loaded the phase is kept until the stance is long enough.
+	um7_gait_phase_t next_phase(um7_gait_phase_t current) const {
+		if (heel_loaded && toe_loaded) return UM7_GAIT_FLAT;
+		if (heel_loaded) return UM7_GAIT_LOADING;
+		if (toe_loaded) return UM7_GAIT_PUSH_OFF;
+		return current;
+	}
+
+	void set_phase(um7_gait_phase_t p, uint32_t t) {
+		phase = p;
+		phase_start = t;
+	}
+
+	// i is the bit number of the event
+	uint8_t publish(uint8_t i, uint32_t t) {
+		event_t[i] = t;
+		event_count[i]++;
+		return 1 << i;
+	}
+
+	bool heel_loaded, toe_loaded;
+	bool started;
+	bool peak_armed, peak_seen;
+	uint32_t phase_start;
+	uint32_t last_t;
+	float last_dps;
+};
+
+#endif
@@ -0,0 +1,173 @@
+/*
+
+Real-time knee joint angles from a thigh and a shank UM7. See UM7Joint.h.
+
+All angle formulas below are ratios of quaternion products, so they don't
+need unit quaternions. The fixed point path keeps the raw UM7 counts
+(2^15 / 1.1 per unit) and only shifts after each product to stay in 32 bits.
+
+*/
+
+#include "MYUM7SPI.h"
+
+// Compiled into every sketch (flat library layout), only built when the quaternion group is stored
+#if UM7_STORE_QUAT
+
+#include "UM7Joint.h"
+
+UM7KneeAngle::UM7KneeAngle(MYUM7SPI& thigh_, MYUM7SPI& shank_, uint16_t budget_us_)
+	: thigh(thigh_), shank(shank_), budget_us(budget_us_) {
+	angles.flexion = 0;
+	angles.abduction = 0;
+	angles.rotation = 0;
+	angles.t = 0;
+	angles.latency = 0;
+	max_latency = 0;
+	overruns = 0;
+	for (int i = 0; i < 4; i++) {
+		relative[i] = 0;
+		neutral[i] = 0;
+	}
+	has_neutral = false;
+}
+
+#if UM7_JOINT_FIXED
+
+// Integer square root
+static uint32_t isqrt(uint32_t v) {
+	uint32_t r = 0, bit = 1UL << 30;
+	while (bit > v) bit >>= 2;
+	while (bit) {
+		if (v >= r + bit) {
+			v -= r + bit;
+			r = (r >> 1) + bit;
+		} else {
+			r >>= 1;
+		}
+		bit >>= 2;
+	}
+	return r;
+}
+
+// atan2 in hundredths of a degree, max error ~0.09 deg.
+// Only one 32 bit divide, the Teensy LC has no hardware divider.
+static int16_t atan2_cdeg(int32_t y, int32_t x) {
+	uint32_t ay = y < 0 ? -y : y;
+	uint32_t ax = x < 0 ? -x : x;
+	if (ax == 0 && ay == 0) return 0;
+
+	bool swap = ay > ax;
+	uint32_t num = swap ? ax : ay;
+	uint32_t den = swap ? ay : ax;
+	while (den >= 0x10000UL) {
+		num >>= 1;
+		den >>= 1;
+	}
+	// z = num/den in Q15, 0..1
+	int32_t z = (int32_t)((num << 15) / den);
+
+	// atan(z) = pi/4 z - z (z - 1)(0.2447 + 0.0663 z), in hundredths of a degree
+	int32_t a = 1402 + ((380 * z) >> 15);
+	int32_t b = 4500 + ((a * (32768 - z)) >> 15);
+	int32_t angle = (b * z) >> 15;
+
+	if (swap) angle = 9000 - angle;
+	if (x < 0) angle = 18000 - angle;
+	if (y < 0) angle = -angle;
+	return angle;
+}
+
+// out = conj(a) * b, scaled down by 2^15
+static void qmul_conj(const int16_t* a, const int16_t* b, int16_t* out) {
+	int32_t w1 = a[0], x1 = a[1], y1 = a[2], z1 = a[3];
+	int32_t w2 = b[0], x2 = b[1], y2 = b[2], z2 = b[3];
+	out[0] = (w1 * w2 + x1 * x2 + y1 * y2 + z1 * z2) >> 15;
+	out[1] = (w1 * x2 - x1 * w2 - y1 * z2 + z1 * y2) >> 15;
+	out[2] = (w1 * y2 + x1 * z2 - y1 * w2 - z1 * x2) >> 15;
+	out[3] = (w1 * z2 - x1 * y2 + y1 * x2 - z1 * w2) >> 15;
+}
+
+void UM7KneeAngle::compute(const int16_t* thigh_q, const int16_t* shank_q) {
+	int16_t q[4];
+	qmul_conj(thigh_q, shank_q, relative);
+	if (has_neutral) {
+		qmul_conj(neutral, relative, q);
+	} else {
+		for (int i = 0; i < 4; i++) q[i] = relative[i];
+	}
+	int32_t w = q[0], x = q[1], y = q[2], z = q[3];
+	int32_t ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+
+	angles.flexion = atan2_cdeg(2 * (w * x - y * z), ww - xx - yy + zz);
+	angles.rotation = atan2_cdeg(2 * (w * z - x * y), ww + xx - yy - zz);
+
+	// asin(s / n) as atan2(s, sqrt(n^2 - s^2)), shifted down so n^2 fits in 32 bits
+	int32_t s = (2 * (x * z + w * y)) >> 15;
+	int32_t n = (ww + xx + yy + zz) >> 15;
+	int32_t c2 = n * n - s * s;
+	angles.abduction = atan2_cdeg(s, isqrt(c2 > 0 ? c2 : 0));
+}
+
+#else
+
+static const float RAD_TO_CDEG = 5729.5779513f;
+
+// out = conj(a) * b
+static void qmul_conj(const float* a, const float* b, float* out) {
+	out[0] = a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
+	out[1] = a[0] * b[1] - a[1] * b[0] - a[2] * b[3] + a[3] * b[2];
+	out[2] = a[0] * b[2] + a[1] * b[3] - a[2] * b[0] - a[3] * b[1];
+	out[3] = a[0] * b[3] - a[1] * b[2] + a[2] * b[1] - a[3] * b[0];
+}
+
+void UM7KneeAngle::compute(const int16_t* thigh_q, const int16_t* shank_q) {
+	float t[4], s[4], q[4];
+	for (int i = 0; i < 4; i++) {
+		t[i] = thigh_q[i];
+		s[i] = shank_q[i];
+	}
+	qmul_conj(t, s, relative);
+	if (has_neutral) {
+		qmul_conj(neutral, relative, q);
+	} else {
+		for (int i = 0; i < 4; i++) q[i] = relative[i];
+	}
+	float w = q[0], x = q[1], y = q[2], z = q[3];
+	float ww = w * w, xx = x * x, yy = y * y, zz = z * z;
+	float sb = 2.0f * (x * z + w * y);
+	float n = ww + xx + yy + zz;
+
+	angles.flexion = atan2f(2.0f * (w * x - y * z), ww - xx - yy + zz) * RAD_TO_CDEG;
+	angles.rotation = atan2f(2.0f * (w * z - x * y), ww + xx - yy - zz) * RAD_TO_CDEG;
+	angles.abduction = atan2f(sb, sqrtf(fmaxf(n * n - sb * sb, 0.0f))) * RAD_TO_CDEG;
+}
+
+#endif
+
+const um7_joint_angles_t& UM7KneeAngle::update() {
+	uint32_t t0 = micros();
+
+	thigh.get_quat_data();
+	shank.get_quat_data();
+	int16_t tq[4] = { thigh.quat_a, thigh.quat_b, thigh.quat_c, thigh.quat_d };
+	int16_t sq[4] = { shank.quat_a, shank.quat_b, shank.quat_c, shank.quat_d };
+	compute(tq, sq);
+
+	uint32_t dt = micros() - t0;
+	angles.t = t0;
+	angles.latency = dt > 0xFFFF ? 0xFFFF : dt;
+	if (angles.latency > max_latency) max_latency = angles.latency;
+	if (angles.latency > budget_us) overruns++;
+	return angles;
+}
+
+void UM7KneeAngle::set_neutral() {
+	for (int i = 0; i < 4; i++) neutral[i] = relative[i];
+	has_neutral = true;
+}
+
+void UM7KneeAngle::clear_neutral() {
+	has_neutral = false;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*
+
+Real-time knee joint angles from a thigh and a shank UM7.
+
+Reads DREG_QUAT_AB/DREG_QUAT_CD from both sensors, takes the rotation of the
+shank relative to the thigh and decomposes it into the Grood & Suntay style
+angles:
+
+ - flexion   about the thigh medio-lateral axis (sensor x)
+ - abduction about the floating axis (sensor y)
+ - rotation  about the shank long axis (sensor z)
+
+Both sensors are assumed to be mounted with x along the flexion axis and z
+along the segment. set_neutral() while standing with the knee straight
+removes any remaining mounting offset.
+
+The math runs in fixed point on boards without a single precision FPU
+(Teensy LC, Teensy 3.2) and in float on the Teensy 3.5/3.6. Define
+UM7_JOINT_FIXED as 0 or 1 to override.
+
+The work per update is fixed (4 SPI transfers, 3 quaternion products and 3
+atan2), so the latency from the start of the SPI reads to the result is
+bounded. Every update records its latency, the maximum seen, and counts
+updates that exceeded the budget given to the constructor.
+
+*/
+
+#ifndef UM7JOINT_H
+#define UM7JOINT_H
+
+#include "MYUM7SPI.h"
+
+#if !UM7_STORE_QUAT
+// Only sketches that use UM7KneeAngle include this, UM7Joint.cpp itself builds to nothing without it
+#error UM7Joint.h needs UM7_STORE_QUAT enabled in MYUM7SPIConfig.h
+#endif
+
+#ifndef UM7_JOINT_FIXED
+#if defined(__ARM_FP) && (__ARM_FP & 4)
+#define UM7_JOINT_FIXED 0
+#else
+#define UM7_JOINT_FIXED 1
+#endif
+#endif
+
+#if UM7_JOINT_FIXED
+typedef int16_t um7_joint_q_t;
+#else
+typedef float um7_joint_q_t;
+#endif
+
+// Latest joint angles
+struct um7_joint_angles_t {
+	int16_t flexion, abduction, rotation; // hundredths of a degree
+	uint32_t t;       // micros() at the start of the SPI reads
+	uint16_t latency; // usec from the start of the SPI reads to the result
+};
+
+class UM7KneeAngle {
+
+public:
+
+	// budget_us_ is the allowed latency, normally one sample period
+	UM7KneeAngle(MYUM7SPI& thigh_, MYUM7SPI& shank_, uint16_t budget_us_);
+
+	// Reads both sensors and computes the angles
+	const um7_joint_angles_t& update();
+
+	// Computes the angles from raw UM7 quaternion counts (a, b, c, d) without reading the sensors
+	void compute(const int16_t* thigh_q, const int16_t* shank_q);
+
+	// Uses the relative pose of the last update as zero, call while standing with the knee straight
+	void set_neutral();
+	void clear_neutral();
+
+	um7_joint_angles_t angles;
+	uint16_t max_latency;
+	uint32_t overruns;
+
+private:
+
+	MYUM7SPI& thigh;
+	MYUM7SPI& shank;
+	uint16_t budget_us;
+
+	// Relative pose of the last update and the neutral pose (w, x, y, z, not unit length)
+	um7_joint_q_t relative[4];
+	um7_joint_q_t neutral[4];
+	bool has_neutral;
+};
+
+#endif
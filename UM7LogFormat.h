@@ -0,0 +1,28 @@
+/*
+
+Layout of the .bin files written by the SD logger examples.
+
+A file is one dummy sector followed by data_t records packed back to back
+(UM7SectorFifo.h), each starting with its uint32 micros() time "t". The
+record sizes below are checked against sizeof(data_t) in the examples, and
+are the defaults of the host tools in extras/host, so a data_t change that
+isn't reflected here fails to compile instead of producing misaligned
+reads on the host.
+
+This header has no Arduino dependencies so the host tools share it.
+
+*/
+
+#ifndef UM7LOGFORMAT_H
+#define UM7LOGFORMAT_H
+
+// The first record follows the dummy sector
+#define UM7_LOG_DATA_OFFSET 512
+
+// sizeof(data_t) of Teensy_DEDICATED_SPI_UM7 (ExFatLogger.h), with FSR_PER_RECORD = 4
+#define UM7_LOG_DEDICATED_RECORD_SIZE 116
+
+// sizeof(data_t) of Individual_Teensys (Parameters.h)
+#define UM7_LOG_INDIVIDUAL_RECORD_SIZE 40
+
+#endif
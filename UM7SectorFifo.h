@@ -0,0 +1,88 @@
+/*
+
+Byte FIFO that packs logger records of any size back to back and hands them
+to the SD card as whole 512 Byte sectors.
+
+Records may straddle sector boundaries, so data_t no longer needs padding
+to a power of two: a 100 Byte record costs 100 Bytes of SD bandwidth instead
+of 128. The buffer is a whole number of sectors and sectors are only removed
+from the front, so every sector handed out is contiguous and 512 aligned
+within the buffer, ready for binFile.write(fifo.sector(), 512).
+
+Readers of the file just read sizeof(data_t) Bytes at a time after the
+first (dummy) sector. Copy records out of a byte buffer with memcpy rather
+than casting, the Teensy LC faults on unaligned float access.
+
+*/
+
+#ifndef UM7SECTORFIFO_H
+#define UM7SECTORFIFO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+
+#define UM7_SECTOR_SIZE 512
+
+template <size_t SECTORS>
+class UM7SectorFifo {
+
+public:
+
+	static const size_t SIZE = SECTORS * UM7_SECTOR_SIZE;
+
+	UM7SectorFifo() : head(0), tail(0), count(0) {}
+
+	// Appends a record. Returns false, without writing anything, if it doesn't fit.
+	bool push(const void* rec, size_t n) {
+		if (n > SIZE - count) return false;
+		const uint8_t* src = (const uint8_t*)rec;
+		size_t first = SIZE - head;
+		if (first >= n) {
+			memcpy(bytes() + head, src, n);
+		} else {
+			memcpy(bytes() + head, src, first);
+			memcpy(bytes(), src + first, n - first);
+		}
+		head = head + n < SIZE ? head + n : head + n - SIZE;
+		count += n;
+		return true;
+	}
+
+	// Whole sectors ready to write
+	size_t sectors() const { return count / UM7_SECTOR_SIZE; }
+
+	// Oldest whole sector, only valid while sectors() > 0
+	const uint8_t* sector() const { return bytes() + tail; }
+
+	// Drops the oldest sector once it's written
+	void pop() {
+		tail = tail + UM7_SECTOR_SIZE < SIZE ? tail + UM7_SECTOR_SIZE : 0;
+		count -= UM7_SECTOR_SIZE;
+	}
+
+	// Zero fills the last partial sector so it can be written at the end of a session.
+	// Returns the number of pad Bytes, truncate the file by that much afterwards.
+	size_t pad() {
+		size_t n = (UM7_SECTOR_SIZE - count % UM7_SECTOR_SIZE) % UM7_SECTOR_SIZE;
+		memset(bytes() + head, 0, n);
+		head = head + n < SIZE ? head + n : 0;
+		count += n;
+		return n;
+	}
+
+	// Bytes buffered and free
+	size_t size() const { return count; }
+	size_t space() const { return SIZE - count; }
+
+private:
+
+	uint8_t* bytes() { return (uint8_t*)buf; }
+	const uint8_t* bytes() const { return (const uint8_t*)buf; }
+
+	// uint32_t keeps the sectors word aligned for the SD driver
+	uint32_t buf[SIZE / 4];
+	size_t head, tail, count;
+};
+
+#endif
@@ -0,0 +1,104 @@
+/*
+
+Double-buffered seqlock for sharing a sample between an ISR and the main
+loop (or between threads on a host) without disabling interrupts.
+
+One writer calls write(), any number of readers call read(). The writer
+never waits. It fills the slot readers aren't using and then publishes it by
+bumping the sequence counter, so a reader only has to retry if the writer
+completes a whole write and starts the next one during its copy. A reader
+interrupting the writer (an ISR reading while the main loop samples)
+therefore always succeeds on the first try.
+
+The counter goes up by 2 per write: odd while a write is in progress, and
+seq / 2 is the number of completed writes.
+
+Uses the GCC __atomic builtins so the same header works on the Teensy and
+on Linux. The slots are copied a word at a time with relaxed atomic loads and
+stores (plain ldr/str on ARM) so a copy racing the writer isn't a data race.
+ThreadSanitizer doesn't understand fences, under -fsanitize=thread the word
+accesses carry the acquire/release ordering instead
+(extras/host/um7_seqlock_stress).
+
+*/
+
+#ifndef UM7SEQLOCK_H
+#define UM7SEQLOCK_H
+
+#include <stdint.h>
+#include <string.h>
+
+#if defined(__SANITIZE_THREAD__)
+#define UM7_SEQLOCK_FENCE(order)
+#define UM7_SEQLOCK_LOAD_ORDER __ATOMIC_ACQUIRE
+#define UM7_SEQLOCK_STORE_ORDER __ATOMIC_RELEASE
+#else
+#define UM7_SEQLOCK_FENCE(order) __atomic_thread_fence(order)
+#define UM7_SEQLOCK_LOAD_ORDER __ATOMIC_RELAXED
+#define UM7_SEQLOCK_STORE_ORDER __ATOMIC_RELAXED
+#endif
+
+template <typename T>
+class UM7Seqlock {
+
+public:
+
+	UM7Seqlock() : seq(0) {
+		memset(buf, 0, sizeof(buf));
+	}
+
+	// Publishes a new value. Only one context may write.
+	void write(const T& v) {
+		uint32_t s = __atomic_load_n(&seq, __ATOMIC_RELAXED);
+		__atomic_store_n(&seq, s + 1, __ATOMIC_RELAXED);
+		UM7_SEQLOCK_FENCE(__ATOMIC_RELEASE);
+		// Slot of the next write, readers use the other one
+		uint32_t* dst = buf[((s >> 1) + 1) & 1];
+		const uint8_t* src = (const uint8_t*)&v;
+		for (uint32_t i = 0; i < WORDS; i++) {
+			uint32_t w = 0;
+			memcpy(&w, src + 4 * i, word_bytes(i));
+			__atomic_store_n(&dst[i], w, UM7_SEQLOCK_STORE_ORDER);
+		}
+		__atomic_store_n(&seq, s + 2, __ATOMIC_RELEASE);
+	}
+
+	// Copies the latest value into "out". Returns the number of writes so far
+	// (the copy is the value of that write), 0 if nothing was written yet.
+	uint32_t read(T& out) const {
+		while (true) {
+			uint32_t s1 = __atomic_load_n(&seq, __ATOMIC_ACQUIRE);
+			uint32_t n = s1 >> 1;
+			if (n == 0) return 0;
+			const uint32_t* src = buf[n & 1];
+			uint8_t* dst = (uint8_t*)&out;
+			for (uint32_t i = 0; i < WORDS; i++) {
+				uint32_t w = __atomic_load_n(&src[i], UM7_SEQLOCK_LOAD_ORDER);
+				memcpy(dst + 4 * i, &w, word_bytes(i));
+			}
+			UM7_SEQLOCK_FENCE(__ATOMIC_ACQUIRE);
+			uint32_t s2 = __atomic_load_n(&seq, __ATOMIC_RELAXED);
+			// The slot is only rewritten by write n + 2, which makes seq 2n + 3
+			if (s2 - (n << 1) <= 2) return n;
+		}
+	}
+
+	// Number of completed writes
+	uint32_t count() const {
+		return __atomic_load_n(&seq, __ATOMIC_ACQUIRE) >> 1;
+	}
+
+private:
+
+	static const uint32_t WORDS = (sizeof(T) + 3) / 4;
+
+	// Bytes of T in word i, less than 4 only in the last word
+	static uint32_t word_bytes(uint32_t i) {
+		return i + 1 < WORDS ? 4 : sizeof(T) - 4 * i;
+	}
+
+	uint32_t seq;
+	uint32_t buf[2][WORDS];
+};
+
+#endif
@@ -0,0 +1,58 @@
+/*
+
+SPI transaction tracer. See UM7Trace.h.
+
+*/
+
+#include "UM7Trace.h"
+
+#if UM7_TRACE
+
+UM7Trace um7_trace;
+
+UM7Trace::UM7Trace() {
+	clear();
+}
+
+void UM7Trace::clear() {
+	count = 0;
+	running = true;
+}
+
+void UM7Trace::add(const um7_trace_span_t& span, uint8_t kind, uint8_t id, uint8_t address, uint8_t bytes) {
+	if (!running) return;
+	uint32_t end = micros();
+	um7_trace_event_t& e = events[count % UM7_TRACE_EVENTS];
+	e.start = span.start;
+	e.cs_low = span.cs_low;
+	// Spans that never marked CS high (non-SPI) cover the whole span
+	e.cs_high = span.cs_high == span.start ? end : span.cs_high;
+	e.end = end;
+	e.kind = kind;
+	e.id = id;
+	e.address = address;
+	e.bytes = bytes;
+	count++;
+}
+
+void UM7Trace::dump(Print* pr) const {
+	uint32_t n = count < UM7_TRACE_EVENTS ? count : UM7_TRACE_EVENTS;
+	pr->print(F("TRACE EVENTS,"));
+	pr->print(n);
+	pr->print(F(",overwritten,"));
+	pr->println(count - n);
+	for (uint32_t i = count - n; i != count; i++) {
+		const um7_trace_event_t& e = events[i % UM7_TRACE_EVENTS];
+		pr->print(F("TRACE,"));
+		pr->print(e.kind);
+		pr->write(','); pr->print(e.id);
+		pr->write(','); pr->print(e.address);
+		pr->write(','); pr->print(e.bytes);
+		pr->write(','); pr->print(e.start);
+		pr->write(','); pr->print(e.cs_low);
+		pr->write(','); pr->print(e.cs_high);
+		pr->write(','); pr->println(e.end);
+	}
+}
+
+#endif
@@ -0,0 +1,100 @@
+/*
+
+SPI transaction tracer for profiling the UM7 bus and the logging loop.
+
+With UM7_TRACE set (MYUM7SPIConfig.h) every read_register() and
+write_register() records its start (before SPI.beginTransaction), CS low,
+CS high and end (after SPI.endTransaction) in micros(), with the CS pin,
+register address and number of bytes clocked. Sketches add their own spans
+(a whole logRecord(), an SD sector write) with the same macros.
+
+Events go into a RAM ring of UM7_TRACE_EVENTS entries, the oldest are
+overwritten. UM7_TRACE_STOP() freezes the ring, e.g. on the first overrun,
+so it holds the time leading up to it. dump() prints it as "TRACE," csv
+lines, extras/host/um7_trace_json converts a capture of them to Chrome /
+Perfetto trace JSON.
+
+Without UM7_TRACE the macros expand to nothing and no buffer is allocated.
+
+*/
+
+#ifndef UM7TRACE_H
+#define UM7TRACE_H
+
+#include "MYUM7SPIConfig.h"
+
+// Event kinds
+#define UM7_TRACE_READ 0
+#define UM7_TRACE_WRITE 1
+#define UM7_TRACE_RECORD 2 // one logRecord(), id 0
+#define UM7_TRACE_SD_WRITE 3 // one sector write, id 0
+#define UM7_TRACE_USER 4
+
+#if UM7_TRACE
+
+#if defined(ARDUINO) && ARDUINO >= 100
+#include "Arduino.h"
+#else
+#include "WProgram.h"
+#endif
+
+// 20 Bytes each. For SPI events id is the CS pin, other kinds leave cs_low/cs_high at start/end.
+struct um7_trace_event_t {
+	uint32_t start, cs_low, cs_high, end;
+	uint8_t kind;
+	uint8_t id;
+	uint8_t address;
+	uint8_t bytes;
+};
+
+// Times of a span in progress
+struct um7_trace_span_t {
+	uint32_t start, cs_low, cs_high;
+};
+
+class UM7Trace {
+
+public:
+
+	UM7Trace();
+
+	void add(const um7_trace_span_t& span, uint8_t kind, uint8_t id, uint8_t address, uint8_t bytes);
+
+	// Empties the ring and starts recording
+	void clear();
+	// Stops recording, the ring keeps what it has until clear()
+	void stop() { running = false; }
+
+	// Prints the events oldest first, one "TRACE,kind,id,address,bytes,start,cs_low,cs_high,end" line each
+	void dump(Print* pr) const;
+
+	// Events recorded since clear(), including the overwritten ones
+	uint32_t count;
+
+private:
+
+	um7_trace_event_t events[UM7_TRACE_EVENTS];
+	bool running;
+};
+
+extern UM7Trace um7_trace;
+
+#define UM7_TRACE_BEGIN(span) um7_trace_span_t span; span.start = span.cs_low = span.cs_high = micros()
+#define UM7_TRACE_CS_LOW(span) span.cs_low = micros()
+#define UM7_TRACE_CS_HIGH(span) span.cs_high = micros()
+#define UM7_TRACE_END(span, kind, id, address, bytes) um7_trace.add(span, kind, id, address, bytes)
+#define UM7_TRACE_CLEAR() um7_trace.clear()
+#define UM7_TRACE_STOP() um7_trace.stop()
+
+#else
+
+#define UM7_TRACE_BEGIN(span)
+#define UM7_TRACE_CS_LOW(span)
+#define UM7_TRACE_CS_HIGH(span)
+#define UM7_TRACE_END(span, kind, id, address, bytes)
+#define UM7_TRACE_CLEAR()
+#define UM7_TRACE_STOP()
+
+#endif
+
+#endif
@@ -117,7 +117,12 @@ void binaryToCsv() {
   Serial.println(F("Converting binary data..."));
   uint8_t lastPct = 0;
   uint32_t start = millis();
-  data_t binData[FIFO_DIM];
+  // Records straddle sector boundaries, so read whole sectors
+  // and carry the partial record over to the next read.
+  const size_t READ_SIZE = 512 * (FIFO_SIZE_SECTORS < 4 ? FIFO_SIZE_SECTORS : 4);
+  uint8_t binData[READ_SIZE + sizeof(data_t)];
+  size_t nh = 0;
+  data_t record;
 
   if (!binFile.seekSet(512)) {
     error("binFile.seek failed");
@@ -132,15 +137,20 @@ void binaryToCsv() {
   while (!Serial.available() && binFile.available()) {
     
     // Returns the number of bytes read in binData
-    int nb = binFile.read(binData, sizeof(binData));
+    int nb = binFile.read(binData + nh, READ_SIZE);
     if (nb <= 0 ) {
       error("read binFile failed");
     }
-    // nr is the number of data_t instances logged
-    size_t nr = nb/sizeof(data_t);
+    nh += nb;
+    // nr is the number of whole data_t instances read so far.
+    // Copy each out, records in binData aren't aligned.
+    size_t nr = nh/sizeof(data_t);
     for (size_t i = 0; i < nr; i++) {
-      printRecord(&csvFile, &binData[i], test);
+      memcpy(&record, binData + i*sizeof(data_t), sizeof(data_t));
+      printRecord(&csvFile, &record, test);
     }
+    nh -= nr*sizeof(data_t);
+    memmove(binData, binData + nr*sizeof(data_t), nh);
 
     if ((millis() - tPct) > 1000) {
       uint8_t pct = binFile.curPosition()/(binFile.fileSize()/100);
@@ -223,14 +233,14 @@ void logData() {
   uint32_t maxLogMicros = 0;
   uint32_t maxWriteMicros = 0;
   size_t maxFifoUse = 0;
-  size_t fifoCount = 0;
-  size_t fifoHead = 0;
-  size_t fifoTail = 0;
   uint16_t overrun = 0;
   uint16_t maxOverrun = 0;
   uint32_t totalOverrun = 0;
-  uint32_t fifoBuf[128*FIFO_SIZE_SECTORS];
-  data_t* fifoData = (data_t*)fifoBuf;
+  // Total bytes of records logged, the file is truncated to this at the end
+  uint64_t logBytes = 0;
+  // Records are packed back to back and written as whole sectors
+  UM7SectorFifo<FIFO_SIZE_SECTORS> fifo;
+  data_t record;
 
   Serial.println();
   Serial.println(F("Hit button to start logging..."));
@@ -242,9 +252,9 @@ void logData() {
   delay(1000);
   
   // Write dummy sector to start multi-block write.
-  dbgAssert(sizeof(fifoBuf) >= 512);
-  memset(fifoBuf, 0, sizeof(fifoBuf));
-  if (binFile.write(fifoBuf, 512) != 512) {
+  uint8_t dummy[512];
+  memset(dummy, 0, sizeof(dummy));
+  if (binFile.write(dummy, 512) != 512) {
     error("write first sector failed");
   }
   serialClearInput();
@@ -274,15 +284,15 @@ void logData() {
       delta = micros() - logTime;
     }
 
-    if (fifoCount < FIFO_DIM) {
+    if (fifo.space() >= sizeof(data_t)) {
       uint32_t m = micros();
-      logRecord(fifoData + fifoHead);
+      logRecord(&record);
       m = micros() - m;
       if (m > maxLogMicros) {
         maxLogMicros = m;
       }
-      fifoHead = fifoHead < (FIFO_DIM - 1) ? fifoHead + 1 : 0;
-      fifoCount++;
+      fifo.push(&record, sizeof(data_t));
+      logBytes += sizeof(data_t);
       if (overrun) {
         if (overrun > maxOverrun) {
           maxOverrun = overrun;
@@ -302,24 +312,21 @@ void logData() {
     }
     // Write data if SD is not busy.
     if (!sd.card()->isBusy()) {
-      size_t nw = fifoHead > fifoTail ? fifoCount : FIFO_DIM - fifoTail;
-      // Limit write time by not writing more than 512 bytes.
-      const size_t MAX_WRITE = 512/sizeof(data_t);
-      if (nw > MAX_WRITE) nw = MAX_WRITE;
-      size_t nb = nw*sizeof(data_t);
-      uint32_t usec = micros();
-      if (nb != binFile.write(fifoData + fifoTail, nb)) {
-        error("write binFile failed");
-      }
-      usec = micros() - usec;
-      if (usec > maxWriteMicros) {
-        maxWriteMicros = usec;
-      }
-      fifoTail = (fifoTail + nw) < FIFO_DIM ? fifoTail + nw : 0;
-      if (fifoCount > maxFifoUse) {
-        maxFifoUse = fifoCount;
+      // Limit write time by writing one whole sector at a time.
+      if (fifo.sectors()) {
+        uint32_t usec = micros();
+        if (512 != binFile.write(fifo.sector(), 512)) {
+          error("write binFile failed");
+        }
+        usec = micros() - usec;
+        if (usec > maxWriteMicros) {
+          maxWriteMicros = usec;
+        }
+        if (fifo.size() > maxFifoUse) {
+          maxFifoUse = fifo.size();
+        }
+        fifo.pop();
       }
-      fifoCount -= nw;
       
       // If start button is pushed again, end trial
       if (digitalRead(start_button_pin) == 1) {
@@ -333,7 +340,15 @@ void logData() {
   Serial.print(F("\nLog time: "));
   Serial.print(log_time);
   Serial.println(F(" Seconds"));
-  binFile.truncate();
+  // Write out the last partial sector, then cut the file to the last whole record
+  fifo.pad();
+  while (fifo.sectors()) {
+    if (512 != binFile.write(fifo.sector(), 512)) {
+      error("write binFile failed");
+    }
+    fifo.pop();
+  }
+  binFile.truncate(512 + logBytes);
   binFile.sync();
   Serial.print(("File size: "));
   // Warning cast used for print since fileSize is uint64_t.
@@ -344,7 +359,7 @@ void logData() {
   Serial.print(F("FIFO_DIM: "));
   Serial.println(FIFO_DIM);
   Serial.print(F("maxFifoUse: "));
-  Serial.println(maxFifoUse);
+  Serial.println(maxFifoUse/sizeof(data_t));
   Serial.print(F("maxLogMicros: "));
   Serial.println(maxLogMicros);
   Serial.print(F("maxWriteMicros: "));
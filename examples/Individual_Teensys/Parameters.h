@@ -3,11 +3,13 @@
   | FSR |----(Analog)--->|  3.5   |
   
  Note:
- - Should pad data_t to 2^i for best performance
+ - data_t needs no padding, records are packed across sectors (UM7SectorFifo.h)
 */
 #ifndef Parameters_h
 #define Parameters_h
 #include "MYUM7SPI.h"
+#include "UM7SectorFifo.h"
+#include "UM7LogFormat.h"
 //---------------------------------APPARATUS FREQUENCIES---------------------------------
 // Freq for SPI0
 // Should be evenly divisible by 60,000,000 Hz and no more than 10,000,000 Hz
@@ -69,7 +71,7 @@ void setup_imus(byte rate_) {
 // Collection of data custom for application
 // Note: delta is NOT part of data_t, it's computed during conversion based on "t"
 struct data_t {
-  // 98 Byte data transfer:
+  // 38 Byte data transfer, sizeof(data_t) is 40 with the 2 Bytes of tail padding:
   uint32_t t;
   uint16_t fsr_heel;
   uint16_t fsr_toe;
@@ -82,11 +84,9 @@ struct data_t {
   int16_t roll_1;
   int16_t pitch_1;
   int16_t yaw_1;
-
-  // Variable to fill in the transfer to 128 Bytes (30B difference).
-  // 16b * 15 = 240b = 30 Bytes
-//  uint16_t whitespace[15];
 };
+// Read back by the host tools as UM7_LOG_INDIVIDUAL_RECORD_SIZE Bytes, see UM7LogFormat.h
+static_assert(sizeof(data_t) == UM7_LOG_INDIVIDUAL_RECORD_SIZE, "sizeof(data_t) doesn't match UM7LogFormat.h");
 //-----------------------------------PARAMETERS-----------------------------------------
 // You may modify the log file name up to 40 characters.
 // Digits before the dot are file versions, don't edit them!
@@ -162,8 +162,7 @@ const uint64_t PREALLOCATE_SIZE = (uint64_t)PREALLOCATE_SIZE_MiB << 20;
 // Max length of file name including zero byte.
 #define FILE_NAME_DIM 40
 
-// Max number of records to buffer while SD is busy. Should alter factors to result
-// in an integer! (Faster writes)
+// Max number of records to buffer while SD is busy.
 const size_t FIFO_DIM = 512 * FIFO_SIZE_SECTORS / sizeof(data_t);
 
 // Create single sd type
@@ -0,0 +1,68 @@
+/* Arduino Example for real-time knee joint angles from a thigh and a shank UM7
+ *
+ * Ben Milligan, 2020
+ *
+ * Computes flexion, abduction and rotation on the Teensy every sample period
+ * (see UM7Joint.h) instead of offline from the csv. Fixed point on the
+ * Teensy LC, float on the Teensy 3.6.
+ *
+ * Mount both sensors with x along the knee flexion axis and z along the
+ * segment. Stand still with the knee straight for the first second, that
+ * pose is used as zero.
+ *
+ * Tested on:
+ * - [48MHz] Teensy LC
+ * - [180MHz] Teensy 3.6
+ */
+#include <MYUM7SPI.h>
+#include <UM7Joint.h>
+
+// Interval between joint angle updates in microseconds, 4000 usec = 250Hz
+const uint16_t SAMPLE_INTERVAL_USEC = 4000;
+
+// Init the um7's at 10MHz
+MYUM7SPI thigh(6, 10000000); // cs pin for the thigh UM7
+MYUM7SPI shank(9, 10000000); // cs pin for the shank UM7
+
+// The brace controller needs every angle within one sample period
+UM7KneeAngle knee(thigh, shank, SAMPLE_INTERVAL_USEC);
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // Serial acts as a on switch
+
+  SPI.begin();
+
+  // Quaternion registers are only updated in quaternion mode (Q bit), use the magnetometer too
+  thigh.set_misc_ssettings(false, false, true, true);
+  delay(100);
+  shank.set_misc_ssettings(false, false, true, true);
+  delay(1000);
+
+  knee.update();
+  knee.set_neutral();
+}
+
+void loop() {
+  static uint32_t next = micros();
+  static uint16_t n = 0;
+
+  // Wait until time for the next update
+  while ((int32_t)(micros() - next) < 0);
+  next += SAMPLE_INTERVAL_USEC;
+
+  const um7_joint_angles_t& a = knee.update();
+
+  // Hand the angles to the brace controller here.
+
+  // Printing every sample would take longer than the sample period, print at 10Hz
+  if (++n >= 25) {
+    n = 0;
+    Serial.print(a.flexion / 100.0); Serial.print(",");
+    Serial.print(a.abduction / 100.0); Serial.print(",");
+    Serial.print(a.rotation / 100.0); Serial.print(",");
+    Serial.print(a.latency); Serial.print(",");
+    Serial.print(knee.max_latency); Serial.print(",");
+    Serial.println(knee.overruns);
+  }
+}
@@ -0,0 +1,70 @@
+/* Arduino Example for sampling a UM7 in a timer ISR and reading it in the main loop
+ *
+ * Ben Milligan, 2020
+ *
+ * The ISR samples at a fixed rate with get_vals_data(). The main loop reads
+ * whole, consistent samples with snapshot() while the ISR keeps running, no
+ * noInterrupts() needed. The getters are never blocked by the readers.
+ *
+ * Needs UM7_SNAPSHOTS set to 1 in MYUM7SPIConfig.h.
+ *
+ * Tested on:
+ * - [180MHz] Teensy 3.6
+ */
+#include <MYUM7SPI.h>
+
+#if !UM7_SNAPSHOTS
+#error Set UM7_SNAPSHOTS to 1 in MYUM7SPIConfig.h
+#endif
+
+// Interval between samples in microseconds, 4000 usec = 250Hz
+const uint32_t SAMPLE_INTERVAL_USEC = 4000;
+
+// Init the um7 at 10MHz
+MYUM7SPI imu1(6, 10000000); // cs pin
+
+IntervalTimer sampleTimer;
+
+void sampleIsr() {
+  imu1.get_vals_data();
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // Serial acts as a on switch
+
+  SPI.begin();
+
+  imu1.set_all_processed_rate(255);
+  delay(100);
+  imu1.set_orientation_rate(255, 255);
+  delay(100);
+
+  sampleTimer.begin(sampleIsr, SAMPLE_INTERVAL_USEC);
+}
+
+void loop() {
+  static uint32_t last = 0;
+  um7_processed_t p;
+  um7_euler_t e;
+
+  // Each snapshot is one whole getter call, even if the ISR fires during the copy
+  uint32_t n = imu1.snapshot(p);
+  imu1.snapshot(e);
+  if (n == last) return;
+
+  Serial.print(n - last); Serial.print(",");
+  Serial.print(p.gyro_x); Serial.print(",");
+  Serial.print(p.gyro_y); Serial.print(",");
+  Serial.print(p.gyro_z); Serial.print(",");
+  Serial.print(p.accel_x); Serial.print(",");
+  Serial.print(p.accel_y); Serial.print(",");
+  Serial.print(p.accel_z); Serial.print(",");
+  Serial.print(e.roll); Serial.print(",");
+  Serial.print(e.pitch); Serial.print(",");
+  Serial.print(e.yaw); Serial.print(",");
+  Serial.println(p.flags | e.flags, HEX);
+  last = n;
+
+  delay(100);
+}
@@ -0,0 +1,85 @@
+/* Arduino Example for streaming UM7 sensors over USB serial as binary frames
+ *
+ * Ben Milligan, 2020
+ *
+ * Replaces the ASCII prints of the Two_UM7s example, which overload Serial at
+ * 255 Hz, with compact binary frames (see UM7Frame.h):
+ *
+ *  ASCII:  ~70 chars per sensor per sample
+ *  Binary: 8 + 30 * sensors + 2 (CRC) + 2 (COBS) bytes per sample
+ *        = 102 Bytes for 3 sensors, 26 kB/s at 255 Hz
+ *
+ * Every frame has a sequence number and a CRC so the host client in
+ * extras/host can detect dropped or corrupted frames rather than misaligning
+ * columns.
+ *
+ * Tested on:
+ * - [48MHz] Teensy LC
+ * - [180MHz] Teensy 3.6
+ */
+#include <MYUM7SPI.h>
+#include <UM7Frame.h>
+
+// Number of sensors to stream, up to UM7_FRAME_MAX_IMUS
+#define N_IMUS 3
+
+// Interval between frames in microseconds, 4000 usec = 250Hz
+const uint32_t STREAM_INTERVAL_USEC = 4000;
+
+// Init the um7's at 10MHz
+MYUM7SPI imus[N_IMUS] = {
+  MYUM7SPI(6, 10000000), // cs pin 1
+  MYUM7SPI(9, 10000000), // cs pin 2
+  MYUM7SPI(4, 10000000)  // cs pin 3
+};
+
+um7_frame_t frame;
+uint8_t encoded[UM7_FRAME_MAX_ENCODED];
+
+void setup() {
+  // Teensy USB serial runs at USB speed regardless of the baud set here
+  Serial.begin(115200);
+  while (!Serial); // Serial acts as a on switch
+
+  SPI.begin();
+
+  for (int i = 0; i < N_IMUS; i++) {
+    imus[i].set_all_processed_rate(255);
+    delay(100);
+    imus[i].set_orientation_rate(255, 255);
+    delay(100);
+  }
+  frame.seq = 0;
+  frame.n_imus = N_IMUS;
+}
+
+void loop() {
+  static uint32_t t0 = micros();
+  static uint32_t next = t0;
+
+  // Wait until time to stream the next frame
+  while ((int32_t)(micros() - next) < 0);
+  next += STREAM_INTERVAL_USEC;
+
+  frame.t = micros() - t0;
+  for (int i = 0; i < N_IMUS; i++) {
+    imus[i].get_vals_data();
+    frame.imu[i].gx = imus[i].gyro_x;
+    frame.imu[i].gy = imus[i].gyro_y;
+    frame.imu[i].gz = imus[i].gyro_z;
+    frame.imu[i].ax = imus[i].accel_x;
+    frame.imu[i].ay = imus[i].accel_y;
+    frame.imu[i].az = imus[i].accel_z;
+    frame.imu[i].roll = imus[i].roll;
+    frame.imu[i].pitch = imus[i].pitch;
+    frame.imu[i].yaw = imus[i].yaw;
+  }
+
+  size_t n = um7_frame_encode(frame, encoded);
+  // Skip the frame rather than block if the host isn't keeping up,
+  // the sequence gap tells the host it was dropped
+  if (Serial.availableForWrite() >= (int)n) {
+    Serial.write(encoded, n);
+  }
+  frame.seq++;
+}
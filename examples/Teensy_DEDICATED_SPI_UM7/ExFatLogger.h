@@ -1,20 +1,28 @@
 // Avoid IDE problems by defining struct in septate .h file.
-// Pad record so size is a power of two for best write performance.
+// Records are packed across sectors (UM7SectorFifo.h), no padding needed.
 /*
   Size of the total logged dataset in bits:
 
- | PACKET # | TIME | FSR_HEEL | FSR_TOE | IMU_1 | IMU_2 | IMU_3 |
- |    32    |  32  |    16    |    16   |  240  |  240  |  240  |
+ | TIME | FSR_INDEX | GYRO/ACCEL 1-3 | EULER 1-3 | FSR_HEEL | FSR_TOE | FLAGS |
+ |  32  |     32    |   3 * 6 * 32   | 3 * 3 * 16|  16 * 4  |  16 * 4 |   16  |
 
- = 816 bits = 102 Bytes
+ = 928 bits = 116 Bytes (FSR_PER_RECORD = 4)
 
  Note:
- - Should pad until 128 Bytes for best logging performance.
+ - No longer padded to 128 Bytes, records straddle sector boundaries in the file.
+ - The floats come first and all 16 bit fields after them, so there are no
+   alignment holes and sizeof(data_t) is the 116 Bytes above. Keep that order
+   when adding fields.
 */
 #ifndef ExFatLogger_h
 #define ExFatLogger_h
 
 #include "MYUM7SPI.h"
+#include "UM7SectorFifo.h"
+#include "UM7LogFormat.h"
+#include "UM7Decimator.h"
+#include "FsrSampler.h"
+#include "UM7Gait.h"
 
 // Init um7s at 10MHz (max)
 MYUM7SPI imu1(6, 10000000); // cs pin 1
@@ -26,46 +34,67 @@ MYUM7SPI imu3(4, 10000000); // cs pin 3
 #define UM7_SCK_PIN 13
 
 // FSR analog pins
-// Make sure they aren't any SPI bus pins
+// Make sure they aren't any SPI bus pins, and on Teensy both are ADC0 pins
 int fsr_heel_pin = A8, fsr_toe_pin = A9;
 
+// FSRs are sampled continuously every FSR_INTERVAL_USEC (FsrSampler.h, 2kHz),
+// each record holds the FSR_PER_RECORD pairs taken up to its time.
+// Should be LOG_INTERVAL_USEC / FSR_INTERVAL_USEC.
+#define FSR_PER_RECORD 4
+FsrSampler fsr;
+
+// Records between DREG_HEALTH checks, each check costs one register read per UM7
+#define HEALTH_CHECK_RECORDS 250
+
+// Gait events go in the top bits of data_t::flags
+#define GAIT_FLAGS_SHIFT 12
+
 // Collection of data custom for application
 // Note: delta is NOT part of data_t, it's computed during conversion based on "t"
 struct data_t {
-	// 98 Byte data transfer:
+	// 116 Byte data transfer:
 	uint32_t t;
-	uint16_t fsr_heel;
-	uint16_t fsr_toe;
+	// Pair i was taken (fsr_index + i) * FSR_INTERVAL_USEC after the start of the log
+	uint32_t fsr_index;
 	float gx_1;
 	float gy_1;
 	float gz_1;
 	float ax_1;
 	float ay_1;
 	float az_1;
-	int16_t roll_1;
-	int16_t pitch_1;
-	int16_t yaw_1;
 	float gx_2;
 	float gy_2;
 	float gz_2;
 	float ax_2;
 	float ay_2;
 	float az_2;
-	int16_t roll_2;
-	int16_t pitch_2;
-	int16_t yaw_2;
 	float gx_3;
 	float gy_3;
 	float gz_3;
 	float ax_3;
 	float ay_3;
 	float az_3;
+	int16_t roll_1;
+	int16_t pitch_1;
+	int16_t yaw_1;
+	int16_t roll_2;
+	int16_t pitch_2;
+	int16_t yaw_2;
 	int16_t roll_3;
 	int16_t pitch_3;
 	int16_t yaw_3;
+	uint16_t fsr_heel[FSR_PER_RECORD];
+	uint16_t fsr_toe[FSR_PER_RECORD];
 
-	// Variable to fill in the transfer to 128 Bytes (30B difference).
-	// 16b * 15 = 240b = 30 Bytes
-	uint16_t whitespace[15];
+	// UM7_ERR_* validation flags of the sample, 4 bits per imu:
+	// imu1 in bits 3:0, imu2 in bits 7:4, imu3 in bits 11:8.
+	// UM7_GAIT_* events of the record's samples in bits 15:12 (GAIT_FLAGS_SHIFT).
+	uint16_t flags;
 };
+
+// The host tools read records UM7_LOG_DEDICATED_RECORD_SIZE Bytes at a time by default, update it
+// in UM7LogFormat.h when data_t changes. Also fails if a field order leaves padding.
+// Every FSR pair over 4 adds 4 Bytes, pass --record-size to the tools then.
+static_assert(sizeof(data_t) == UM7_LOG_DEDICATED_RECORD_SIZE + 2 * 2 * (FSR_PER_RECORD - 4),
+	"sizeof(data_t) doesn't match UM7LogFormat.h");
 #endif  // ExFatLogger_h
@@ -0,0 +1,213 @@
+// Continuous sampling of the heel and toe FSRs, independent of the UM7 reads.
+/*
+  Teensy 3.x: the PDB triggers ADC0 every FSR_INTERVAL_USEC / 2 and the DMA
+  stores each result in a ring buffer, then rewrites ADC0_SC1A with the
+  other channel for the next trigger. No CPU time is spent per sample.
+
+  Teensy LC (no PDB): an IntervalTimer ISR stores the last result and starts
+  the next conversion, a few usec per call instead of the ~20 usec blocking
+  analogRead().
+
+  Other boards (AVR, ...): nothing runs in the background. update() takes one
+  pair with analogRead() when one is due and repeats it for every interval
+  since the last pair it took, so with records every LOG_INTERVAL_USEC all
+  FSR_PER_RECORD pairs of a record are the same reading. Costs two blocking
+  analogRead() per record, ~220 usec on a 16MHz AVR.
+
+  The heel and toe are converted back to back, a pair every FSR_INTERVAL_USEC.
+  Pair k was taken k * FSR_INTERVAL_USEC after start(), so records carry the
+  index of their first pair instead of a time stamp.
+
+ Note:
+ - On Teensy both pins have to be ADC0 pins.
+ - On Teensy don't call analogRead() while the sampler runs, it owns ADC0.
+ - On Teensy 3.x the sampler uses the PDB, it can't be combined with the Audio library.
+ - Pins on the b side of ADC0 channels 4-7 set MUXSEL for both pins.
+*/
+#ifndef FsrSampler_h
+#define FsrSampler_h
+
+#include <Arduino.h>
+#if defined(KINETISK)
+#include <DMAChannel.h>
+#endif
+
+// Interval between FSR pairs in microseconds, 500 usec = 2kHz
+#ifndef FSR_INTERVAL_USEC
+#define FSR_INTERVAL_USEC 500
+#endif
+
+// Pairs kept in the ring, must be a power of two. 128 pairs = 64ms at 2kHz,
+// update() has to be called at least this often. With analogRead() only
+// update() fills the ring, it has to hold one record's pairs.
+#if defined(KINETISK) || defined(KINETISL)
+#define FSR_RING_PAIRS 128
+#else
+#define FSR_RING_PAIRS 8
+#endif
+
+#if defined(KINETISK) && (F_BUS / 1000000 * FSR_INTERVAL_USEC / 2) > 65535
+#error FSR_INTERVAL_USEC too long for the PDB counter
+#endif
+
+class FsrSampler {
+
+public:
+
+	FsrSampler() : elements(0), last_pos(0) {}
+
+	// Lets the core set up and calibrate ADC0, then learns the channel of each pin
+	void begin(uint8_t heel_pin, uint8_t toe_pin) {
+		memset((void*)ring, 0, sizeof(ring));
+#if defined(KINETISK) || defined(KINETISL)
+		uint8_t mux = 0;
+		analogRead(heel_pin);
+		heel_ch = ADC0_SC1A & ADC_SC1_ADCH(31);
+		mux |= ADC0_CFG2 & ADC_CFG2_MUXSEL;
+		analogRead(toe_pin);
+		toe_ch = ADC0_SC1A & ADC_SC1_ADCH(31);
+		mux |= ADC0_CFG2 & ADC_CFG2_MUXSEL;
+		ADC0_CFG2 |= mux;
+#else
+		heel_ch = heel_pin;
+		toe_ch = toe_pin;
+#endif
+#if defined(KINETISK)
+		// Converted channel order is heel, toe. After each result the DMA writes the next channel.
+		next_ch[0] = toe_ch;
+		next_ch[1] = heel_ch;
+		result_dma.source((volatile uint16_t&)ADC0_RA);
+		result_dma.triggerAtHardwareEvent(DMAMUX_SOURCE_ADC0);
+		mux_dma.destination(ADC0_SC1A);
+		mux_dma.triggerAtTransfersOf(result_dma);
+		SIM_SCGC6 |= SIM_SCGC6_PDB;
+#endif
+	}
+
+	// (Re)starts sampling, pair 0 is taken now
+	void start() {
+		stop();
+		elements = 0;
+		last_pos = 0;
+#if defined(KINETISK)
+		// Rewinds both DMA channels to the start of their buffers
+		result_dma.destinationCircular(ring, sizeof(ring));
+		mux_dma.sourceCircular(next_ch, sizeof(next_ch));
+		mux_dma.enable();
+		result_dma.enable();
+
+		// Hardware trigger, results are read by the DMA
+		ADC0_SC2 |= ADC_SC2_ADTRG | ADC_SC2_DMAEN;
+		ADC0_SC1A = heel_ch;
+
+		PDB0_MOD = F_BUS / 1000000 * FSR_INTERVAL_USEC / 2 - 1;
+		PDB0_IDLY = 0;
+		PDB0_CH0C1 = 0x0101; // pre-trigger 0 enabled, no delay
+		PDB0_SC = PDB_SC_TRGSEL(15) | PDB_SC_PDBEN | PDB_SC_CONT | PDB_SC_LDOK;
+		PDB0_SC = PDB_SC_TRGSEL(15) | PDB_SC_PDBEN | PDB_SC_CONT | PDB_SC_SWTRIG;
+#elif defined(KINETISL)
+		active = this;
+		isr_pos = 0;
+		isr_elements = 0;
+		ADC0_SC1A = heel_ch;
+		timer.begin(isr, FSR_INTERVAL_USEC / 2.0f);
+#else
+		start_us = micros();
+		update();
+#endif
+	}
+
+	void stop() {
+#if defined(KINETISK)
+		PDB0_SC = 0;
+		result_dma.disable();
+		mux_dma.disable();
+		ADC0_SC2 &= ~(ADC_SC2_ADTRG | ADC_SC2_DMAEN);
+#elif defined(KINETISL)
+		timer.end();
+#endif
+	}
+
+	// Catches up with the samples taken since the last call. Returns the number of whole pairs so far.
+	uint32_t update() {
+#if defined(KINETISK)
+		uint32_t pos = (volatile uint16_t*)result_dma.TCD->DADDR - ring;
+		elements += (pos - last_pos) & (FSR_RING_PAIRS * 2 - 1);
+		last_pos = pos;
+#elif defined(KINETISL)
+		elements = isr_elements;
+#else
+		uint32_t due = (micros() - start_us) / FSR_INTERVAL_USEC + 1;
+		uint32_t pairs = elements / 2;
+		if (due > pairs) {
+			uint16_t heel = analogRead(heel_ch);
+			uint16_t toe = analogRead(toe_ch);
+			// Holds the reading for the pairs missed since the last one, only the ring's worth is kept
+			uint32_t k = due - pairs > FSR_RING_PAIRS ? due - FSR_RING_PAIRS : pairs;
+			for (; k < due; k++) {
+				uint32_t j = (k * 2) & (FSR_RING_PAIRS * 2 - 1);
+				ring[j] = heel;
+				ring[j + 1] = toe;
+			}
+			elements = due * 2;
+		}
+#endif
+		return elements / 2;
+	}
+
+	// Copies the last n pairs (n <= FSR_RING_PAIRS) taken up to the last update().
+	// Returns the index of the first one, pairs from before start() read as 0.
+	uint32_t read(uint16_t* heel, uint16_t* toe, uint16_t n) {
+		uint32_t pairs = elements / 2;
+		uint32_t first = pairs - n;
+		for (uint16_t i = 0; i < n; i++) {
+			uint32_t k = first + i;
+			if (k >= pairs) { // before pair 0
+				heel[i] = toe[i] = 0;
+				continue;
+			}
+			uint32_t j = (k * 2) & (FSR_RING_PAIRS * 2 - 1);
+			heel[i] = ring[j];
+			toe[i] = ring[j + 1];
+		}
+		return first;
+	}
+
+private:
+
+	// Circular DMA destinations have to be aligned to their size
+	volatile uint16_t ring[FSR_RING_PAIRS * 2] __attribute__((aligned(FSR_RING_PAIRS * 4)));
+	uint32_t elements;
+	uint32_t last_pos;
+	uint8_t heel_ch, toe_ch; // the pins with analogRead()
+
+#if defined(KINETISK)
+	volatile uint32_t next_ch[2] __attribute__((aligned(8)));
+	DMAChannel result_dma;
+	DMAChannel mux_dma;
+#elif defined(KINETISL)
+	IntervalTimer timer;
+	volatile uint32_t isr_pos;
+	volatile uint32_t isr_elements;
+	static FsrSampler* active;
+
+	static void isr() {
+		FsrSampler* s = active;
+		uint32_t p = s->isr_pos;
+		s->ring[p] = ADC0_RA;
+		p = (p + 1) & (FSR_RING_PAIRS * 2 - 1);
+		s->isr_pos = p;
+		// Starts the next conversion, heel on even positions and toe on odd
+		ADC0_SC1A = (p & 1) ? s->toe_ch : s->heel_ch;
+		s->isr_elements = s->isr_elements + 1;
+	}
+#else
+	uint32_t start_us;
+#endif
+};
+
+#if defined(KINETISL)
+FsrSampler* FsrSampler::active = nullptr;
+#endif
+
+#endif  // FsrSampler_h
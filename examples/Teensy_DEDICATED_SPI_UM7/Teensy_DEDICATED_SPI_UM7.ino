@@ -12,6 +12,8 @@
    - [16MHz] Arduino Uno, slight lag
    - [48MHz] Teensy LC
    - [180MHz] Teensy 3.6, SPI only! Hardware fault in SDIO mode for both 3.5/6
+   The FSRs are sampled in the background at 2kHz on Teensy 3.x and LC only,
+   other boards like the Uno take one analogRead() pair per record (FsrSampler.h).
    
    Notes:
    1. You need to format your SD card as exFAT before this example works,
@@ -60,6 +62,47 @@ typedef FsFile file_t;
 const uint16_t LOG_INTERVAL_USEC = 2000;
 // Use to compare timestamps for missed packets
 const uint16_t MAX_INTERVAL_USEC = 3000;
+
+// Gyro and accel samples filtered into each record, 2^DECIMATION_STAGES (UM7Decimator.h).
+// 0 takes one sample per record. The UM7s update at up to 255Hz (setup_imus()), so keep
+// SAMPLE_INTERVAL_USEC at 4000 or more, e.g. LOG_INTERVAL_USEC 8000 with 1 stage.
+#define DECIMATION_STAGES 0
+const uint32_t SAMPLE_INTERVAL_USEC = LOG_INTERVAL_USEC >> DECIMATION_STAGES;
+//------------------------------------------------------------------------------
+// Event capture ('e' command). Records are kept in a RAM ring and only written
+// around trigger events, each event shows up as a "Missed Packet(s)" gap in the csv.
+// The ring takes CAPTURE_RING_RECORDS * sizeof(data_t) of RAM, so capture is only
+// built for boards with room for the default 64KiB. Set EVENT_CAPTURE to 1 on
+// others after reducing PRETRIGGER_RECORDS.
+#if defined(__MK64FX512__) || defined(__MK66FX1M0__) || defined(__IMXRT1062__)
+// Teensy 3.5, 3.6 and 4.x
+#define EVENT_CAPTURE 1
+#else
+#define EVENT_CAPTURE 0
+#endif
+
+// Records kept from before a trigger, 500 = 1 second at 500Hz.
+// The ring holds 64 more for SD latency, (500 + 64) * 116 Bytes = 64KiB.
+const uint16_t PRETRIGGER_RECORDS = 500;
+#define CAPTURE_RING_RECORDS (PRETRIGGER_RECORDS + 64)
+// Records written after the last trigger, a trigger inside the window extends it
+const uint16_t POSTTRIGGER_RECORDS = 1000;
+
+// Trigger sources, any combination
+#define TRIGGER_FSR 1 // heel or toe FSR at or above FSR_TRIGGER_LEVEL
+#define TRIGGER_GYRO 2 // gyro magnitude of any UM7 at or above GYRO_TRIGGER_DPS
+#define TRIGGER_PIN 4 // TRIGGER_PIN_NUMBER pulled LOW, e.g. a foot switch or sync line
+const uint8_t TRIGGER_SOURCES = TRIGGER_FSR;
+const uint16_t FSR_TRIGGER_LEVEL = 300; // ADC counts
+const float GYRO_TRIGGER_DPS = 200.0;
+const uint8_t TRIGGER_PIN_NUMBER = 2;
+//------------------------------------------------------------------------------
+// Gait events (UM7Gait.h) are detected on every sample, before decimation, and
+// stored in the record flags (GAIT_FLAGS_SHIFT). GAIT_GYRO is the sagittal gyro of
+// the shank UM7, it should read positive in swing, otherwise set GAIT_GYRO_SIGN to -1.
+#define GAIT_GYRO gx_2
+const float GAIT_GYRO_SIGN = 1.0;
+const um7_gait_params_t GAIT_PARAMS = UM7_GAIT_DEFAULT_PARAMS;
 //------------------------------------------------------------------------------
 
 // Initial time before logging starts, set once logging has begun
@@ -121,8 +164,7 @@ MinimumSerial MinSerial;
 // Max length of file name including zero byte.
 #define FILE_NAME_DIM 40
 
-// Max number of records to buffer while SD is busy. Should alter factors to result
-// in an integer! (Faster writes)
+// Max number of records to buffer while SD is busy.
 const size_t FIFO_DIM = 512 * FIFO_SIZE_SECTORS / sizeof(data_t);
 
 // Create single sd type
@@ -135,12 +177,69 @@ file_t csvFile;
 // Boolean used to track whether or not you're just testing the sensors. Won't print
 // the "Missed packet(s)" everytime when testing, otherwise printed in data logging.
 bool test = false;
+
+#if EVENT_CAPTURE
+// Event capture ring, see PRETRIGGER_RECORDS
+data_t captureRing[CAPTURE_RING_RECORDS];
+#endif  // EVENT_CAPTURE
+
+UM7Gait gait(GAIT_PARAMS);
+// Longest gait.update() of the current log
+uint32_t maxGaitMicros = 0;
+
+#if DECIMATION_STAGES
+// Gyro xyz and accel xyz of the three imus, fixed point in 0.01 deg/s and 0.0001 G
+#define DECIMATION_CHANNELS 18
+#define GYRO_COUNTS 100.0f
+#define ACCEL_COUNTS 10000.0f
+UM7Decimator<DECIMATION_CHANNELS, DECIMATION_STAGES> decimator;
+// Flags of the samples of the record in progress, cleared with decimator.reset()
+uint16_t decimatorFlags = 0;
+#endif
 //==============================================================================
+#if DECIMATION_STAGES
+// Converts to the decimator's fixed point, NaN and out of range values are clamped
+int32_t toCounts(float v, float scale, float limit) {
+	if (!(fabsf(v) <= limit)) {
+		v = v > 0 ? limit : (v < 0 ? -limit : 0);
+	}
+	return lroundf(v * scale);
+}
+
+// Runs the gyro and accel of a sample through the decimator. Returns true every
+// 2^DECIMATION_STAGES samples with the filtered values in data. Euler angles wrap
+// around, they're subsampled instead of filtered. Flags collect all samples of the record.
+bool decimate(data_t* data) {
+	float* ch[DECIMATION_CHANNELS] = {
+		&data->gx_1, &data->gy_1, &data->gz_1, &data->ax_1, &data->ay_1, &data->az_1,
+		&data->gx_2, &data->gy_2, &data->gz_2, &data->ax_2, &data->ay_2, &data->az_2,
+		&data->gx_3, &data->gy_3, &data->gz_3, &data->ax_3, &data->ay_3, &data->az_3 };
+	int32_t v[DECIMATION_CHANNELS];
+	for (int i = 0; i < DECIMATION_CHANNELS; i++) {
+		bool gyro = i % 6 < 3;
+		v[i] = toCounts(*ch[i], gyro ? GYRO_COUNTS : ACCEL_COUNTS, gyro ? UM7_GYRO_LIMIT : UM7_ACCEL_LIMIT);
+	}
+	decimatorFlags |= data->flags;
+	if (!decimator.push(v, v)) {
+		return false;
+	}
+	for (int i = 0; i < DECIMATION_CHANNELS; i++) {
+		*ch[i] = v[i] / (i % 6 < 3 ? GYRO_COUNTS : ACCEL_COUNTS);
+	}
+	data->flags = decimatorFlags;
+	decimatorFlags = 0;
+	return true;
+}
+#endif
+//------------------------------------------------------------------------------
 // Replace logRecord(), printRecord(), and ExFatLogger.h for your sensors.
-void logRecord(data_t* data) {
+// Takes one sample every SAMPLE_INTERVAL_USEC, returns true when data holds a whole record.
+bool logRecord(data_t* data) {
+	static uint16_t health_count = 0;
 	data->t = (micros() - t0);
-	data->fsr_heel = analogRead(fsr_heel_pin);
-	data->fsr_toe = analogRead(fsr_toe_pin);
+	// FSRs are already sampled by the ADC in the background, the IMU reads start right away
+	fsr.update();
+	data->fsr_index = fsr.read(data->fsr_heel, data->fsr_toe, FSR_PER_RECORD);
 	imu1.get_vals_data();
 	data->gx_1 = imu1.gyro_x;
 	data->gy_1 = imu1.gyro_y;
@@ -171,7 +270,55 @@ void logRecord(data_t* data) {
 	data->roll_3 = imu3.roll;
 	data->pitch_3 = imu3.pitch;
 	data->yaw_3 = imu3.yaw;
+	// Health is slow to change, only check it every few hundred records
+	if (++health_count >= HEALTH_CHECK_RECORDS) {
+		health_count = 0;
+		imu1.check_health();
+		imu2.check_health();
+		imu3.check_health();
+	}
+	data->flags = imu1.sample_flags | (imu2.sample_flags << 4) | (imu3.sample_flags << 8);
+	// Newest FSR pair and the undecimated gyro, so events aren't delayed by the filter
+	uint32_t m = micros();
+	uint8_t events = gait.update(data->t, data->fsr_heel[FSR_PER_RECORD - 1], data->fsr_toe[FSR_PER_RECORD - 1],
+		GAIT_GYRO_SIGN * data->GAIT_GYRO);
+	m = micros() - m;
+	if (m > maxGaitMicros) {
+		maxGaitMicros = m;
+	}
+	data->flags |= (uint16_t)events << GAIT_FLAGS_SHIFT;
+#if DECIMATION_STAGES
+	return decimate(data);
+#else
+	return true;
+#endif
+}
+//------------------------------------------------------------------------------
+#if EVENT_CAPTURE
+// Returns true if the record starts or extends an event capture
+bool triggered(const data_t* data) {
+	if (TRIGGER_SOURCES & TRIGGER_FSR) {
+		for (int i = 0; i < FSR_PER_RECORD; i++) {
+			if (data->fsr_heel[i] >= FSR_TRIGGER_LEVEL || data->fsr_toe[i] >= FSR_TRIGGER_LEVEL) {
+				return true;
+			}
+		}
+	}
+	if (TRIGGER_SOURCES & TRIGGER_GYRO) {
+		// Compare squares, no sqrt needed
+		const float limit = GYRO_TRIGGER_DPS * GYRO_TRIGGER_DPS;
+		if (data->gx_1*data->gx_1 + data->gy_1*data->gy_1 + data->gz_1*data->gz_1 >= limit ||
+			data->gx_2*data->gx_2 + data->gy_2*data->gy_2 + data->gz_2*data->gz_2 >= limit ||
+			data->gx_3*data->gx_3 + data->gy_3*data->gy_3 + data->gz_3*data->gz_3 >= limit) {
+			return true;
+		}
+	}
+	if ((TRIGGER_SOURCES & TRIGGER_PIN) && digitalRead(TRIGGER_PIN_NUMBER) == LOW) {
+		return true;
+	}
+	return false;
 }
+#endif  // EVENT_CAPTURE
 //------------------------------------------------------------------------------
 void printRecord(Print* pr, data_t* data, bool test_) {
 	static uint32_t nr = 0;
@@ -183,6 +330,19 @@ void printRecord(Print* pr, data_t* data, bool test_) {
 		pr->print(LOG_INTERVAL_USEC);
 		pr->print(F(",microseconds"));
 		pr->println();
+#if DECIMATION_STAGES
+		// Filtered gyro/accel lag the record time by the decimator delay
+		pr->print(F("DECIMATION,"));
+		pr->print(decimator.RATIO);
+		pr->print(F(",delay,"));
+		pr->print((uint32_t)decimator.DELAY * SAMPLE_INTERVAL_USEC);
+		pr->print(F(",microseconds"));
+		pr->println();
+#endif
+		pr->print(F("FSR INTERVAL,"));
+		pr->print(FSR_INTERVAL_USEC);
+		pr->print(F(",microseconds"));
+		pr->println();
 		pr->print(F("TOTAL LOG TIME,"));
 		pr->print(log_time);
 		pr->print(F(",seconds"));
@@ -192,8 +352,13 @@ void printRecord(Print* pr, data_t* data, bool test_) {
 		pr->print(F("TRANSFER #"));
 		pr->print(F(",TIME"));
 		pr->print(F(",TIME DELTA"));
+		pr->print(F(",FSR INDEX"));
 		pr->print(F(",FSR HEEL"));
 		pr->print(F(",FSR TOE"));
+		for (int i = 2; i <= FSR_PER_RECORD; i++) {
+			pr->print(F(",FSR HEEL ")); pr->print(i);
+			pr->print(F(",FSR TOE ")); pr->print(i);
+		}
 		pr->print(F(",G1X"));
 		pr->print(F(",G1Y"));
 		pr->print(F(",G1Z"));
@@ -221,6 +386,7 @@ void printRecord(Print* pr, data_t* data, bool test_) {
 		pr->print(F(",ROLL3"));
 		pr->print(F(",PITCH3"));
 		pr->print(F(",YAW3"));
+		pr->print(F(",FLAGS"));
 		pr->println();
 		nr = 0;
 		return;
@@ -235,8 +401,11 @@ void printRecord(Print* pr, data_t* data, bool test_) {
 	pr->print(nr++);
 	pr->write(','); pr->print(data->t);
 	pr->write(','); pr->print(data->t - delta);
-	pr->write(','); pr->print(data->fsr_heel);
-	pr->write(','); pr->print(data->fsr_toe);
+	pr->write(','); pr->print(data->fsr_index);
+	for (int i = 0; i < FSR_PER_RECORD; i++) {
+		pr->write(','); pr->print(data->fsr_heel[i]);
+		pr->write(','); pr->print(data->fsr_toe[i]);
+	}
 	pr->write(','); pr->print(data->gx_1);
 	pr->write(','); pr->print(data->gy_1);
 	pr->write(','); pr->print(data->gz_1);
@@ -264,6 +433,7 @@ void printRecord(Print* pr, data_t* data, bool test_) {
 	pr->write(','); pr->print(data->roll_3);
 	pr->write(','); pr->print(data->pitch_3);
 	pr->write(','); pr->print(data->yaw_3);
+	pr->write(','); pr->print(data->flags, HEX);
 	pr->println();
 
 	// Reset delta to hold time for the next packet
@@ -278,7 +448,12 @@ void printRecord(Print* pr, data_t* data, bool test_) {
 void binaryToCsv() {
   uint8_t lastPct = 0;
   uint32_t start = millis();
-  data_t binData[FIFO_DIM];
+  // Records straddle sector boundaries, so read whole sectors
+  // and carry the partial record over to the next read.
+  const size_t READ_SIZE = 512 * (FIFO_SIZE_SECTORS < 4 ? FIFO_SIZE_SECTORS : 4);
+  uint8_t binData[READ_SIZE + sizeof(data_t)];
+  size_t nh = 0;
+  data_t record;
 
   if (!binFile.seekSet(512)) {
     error("binFile.seek failed");
@@ -293,15 +468,20 @@ void binaryToCsv() {
   while (!Serial.available() && binFile.available()) {
     
     // Returns the number of bytes read in binData
-    int nb = binFile.read(binData, sizeof(binData));
+    int nb = binFile.read(binData + nh, READ_SIZE);
     if (nb <= 0 ) {
       error("read binFile failed");
     }
-    // nr is the number of data_t instances logged
-    size_t nr = nb/sizeof(data_t);
+    nh += nb;
+    // nr is the number of whole data_t instances read so far.
+    // Copy each out, records in binData aren't aligned.
+    size_t nr = nh/sizeof(data_t);
     for (size_t i = 0; i < nr; i++) {
-      printRecord(&csvFile, &binData[i], test);
+      memcpy(&record, binData + i*sizeof(data_t), sizeof(data_t));
+      printRecord(&csvFile, &record, test);
     }
+    nh -= nr*sizeof(data_t);
+    memmove(binData, binData + nr*sizeof(data_t), nh);
 
     if ((millis() - tPct) > 1000) {
       uint8_t pct = binFile.curPosition()/(binFile.fileSize()/100);
@@ -379,25 +559,37 @@ bool createCsvFile() {
   return true;
 }
 //-------------------------------------------------------------------------------
-void logData() {
+// Logs every record, or with capture set only the records around trigger events.
+// capture is ignored without EVENT_CAPTURE.
+void logData(bool capture) {
   int32_t delta;  // Jitter in log time.
   int32_t maxDelta = 0;
   uint32_t maxLogMicros = 0;
   uint32_t maxWriteMicros = 0;
   size_t maxFifoUse = 0;
-  size_t fifoCount = 0;
-  size_t fifoHead = 0;
-  size_t fifoTail = 0;
   uint16_t overrun = 0;
   uint16_t maxOverrun = 0;
   uint32_t totalOverrun = 0;
-  uint32_t fifoBuf[128*FIFO_SIZE_SECTORS];
-  data_t* fifoData = (data_t*)fifoBuf;
+  // Total bytes of records logged, the file is truncated to this at the end
+  uint64_t logBytes = 0;
+  // Records are packed back to back and written as whole sectors
+  UM7SectorFifo<FIFO_SIZE_SECTORS> fifo;
+  data_t record;
+#if EVENT_CAPTURE
+  // Event capture: records taken, next record to save and one past the last record to save
+  uint32_t head = 0;
+  uint32_t saved = 0;
+  uint32_t saveEnd = 0;
+  uint32_t events = 0;
+  if (capture && (TRIGGER_SOURCES & TRIGGER_PIN)) {
+    pinMode(TRIGGER_PIN_NUMBER, INPUT_PULLUP);
+  }
+#endif  // EVENT_CAPTURE
 
   // Write dummy sector to start multi-block write.
-  dbgAssert(sizeof(fifoBuf) >= 512);
-  memset(fifoBuf, 0, sizeof(fifoBuf));
-  if (binFile.write(fifoBuf, 512) != 512) {
+  uint8_t dummy[512];
+  memset(dummy, 0, sizeof(dummy));
+  if (binFile.write(dummy, 512) != 512) {
     error("write first sector failed");
   }
   serialClearInput();
@@ -410,11 +602,19 @@ void logData() {
   uint32_t m = millis();
 
   t0 = micros();
+  fsr.start();
+  gait.reset();
+  maxGaitMicros = 0;
+  UM7_TRACE_CLEAR();
+#if DECIMATION_STAGES
+  decimator.reset();
+  decimatorFlags = 0;
+#endif
   // Time to log next record.
   uint32_t logTime = micros();
   while (true) {
-    // Time for next data record.
-    logTime += LOG_INTERVAL_USEC;
+    // Time for next sample, one record every 2^DECIMATION_STAGES samples.
+    logTime += SAMPLE_INTERVAL_USEC;
 
     // Wait until time to log data.
     delta = micros() - logTime;
@@ -427,22 +627,79 @@ void logData() {
       delta = micros() - logTime;
     }
 
-    if (fifoCount < FIFO_DIM) {
+    bool lost = false;
+#if EVENT_CAPTURE
+    if (capture) {
+      // Always sample into the ring. A slot still waiting to be saved is lost if the SD fell behind.
+      if (saved < saveEnd && head - saved >= CAPTURE_RING_RECORDS) {
+        UM7_TRACE_STOP();
+        saved++;
+        totalOverrun++;
+        if (ERROR_LED_PIN >= 0) {
+          digitalWrite(ERROR_LED_PIN, HIGH);
+        }
+      }
+      data_t* r = &captureRing[head % CAPTURE_RING_RECORDS];
+      UM7_TRACE_BEGIN(span);
       uint32_t m = micros();
-      logRecord(fifoData + fifoHead);
+      bool whole = logRecord(r);
       m = micros() - m;
+      UM7_TRACE_END(span, UM7_TRACE_RECORD, 0, 0, whole ? sizeof(data_t) : 0);
       if (m > maxLogMicros) {
         maxLogMicros = m;
       }
-      fifoHead = fifoHead < (FIFO_DIM - 1) ? fifoHead + 1 : 0;
-      fifoCount++;
-      if (overrun) {
-        if (overrun > maxOverrun) {
-          maxOverrun = overrun;
+      if (whole) {
+        head++;
+      }
+      if (whole && triggered(r)) {
+        // A new event starts with the pre-trigger history, one inside the post window just extends it
+        if (saved >= saveEnd) {
+          events++;
+          uint32_t first = head > PRETRIGGER_RECORDS ? head - PRETRIGGER_RECORDS : 0;
+          if (saved < first) {
+            saved = first;
+          }
+        }
+        saveEnd = head + POSTTRIGGER_RECORDS;
+      }
+      // Move records waiting to be saved into the sector fifo
+      uint32_t end = saveEnd < head ? saveEnd : head;
+      while (saved < end && fifo.space() >= sizeof(data_t)) {
+        fifo.push(&captureRing[saved % CAPTURE_RING_RECORDS], sizeof(data_t));
+        logBytes += sizeof(data_t);
+        saved++;
+      }
+    } else
+#endif  // EVENT_CAPTURE
+    if (DECIMATION_STAGES || fifo.space() >= sizeof(data_t)) {
+      // The decimator needs every sample, a whole record that doesn't fit is lost
+      UM7_TRACE_BEGIN(span);
+      uint32_t m = micros();
+      bool whole = logRecord(&record);
+      m = micros() - m;
+      UM7_TRACE_END(span, UM7_TRACE_RECORD, 0, 0, whole ? sizeof(data_t) : 0);
+      if (m > maxLogMicros) {
+        maxLogMicros = m;
+      }
+      if (whole) {
+        if (fifo.push(&record, sizeof(data_t))) {
+          logBytes += sizeof(data_t);
+          if (overrun) {
+            if (overrun > maxOverrun) {
+              maxOverrun = overrun;
+            }
+            overrun = 0;
+          }
+        } else {
+          lost = true;
         }
-        overrun = 0;
       }
     } else {
+      lost = true;
+    }
+    if (lost) {
+      // Keep the trace leading up to the first overrun
+      UM7_TRACE_STOP();
       totalOverrun++;
       overrun++;
       if (overrun > 0XFFF) {
@@ -458,24 +715,23 @@ void logData() {
     }
     // Write data if SD is not busy.
     if (!sd.card()->isBusy()) {
-      size_t nw = fifoHead > fifoTail ? fifoCount : FIFO_DIM - fifoTail;
-      // Limit write time by not writing more than 512 bytes.
-      const size_t MAX_WRITE = 512/sizeof(data_t);
-      if (nw > MAX_WRITE) nw = MAX_WRITE;
-      size_t nb = nw*sizeof(data_t);
-      uint32_t usec = micros();
-      if (nb != binFile.write(fifoData + fifoTail, nb)) {
-        error("write binFile failed");
-      }
-      usec = micros() - usec;
-      if (usec > maxWriteMicros) {
-        maxWriteMicros = usec;
-      }
-      fifoTail = (fifoTail + nw) < FIFO_DIM ? fifoTail + nw : 0;
-      if (fifoCount > maxFifoUse) {
-        maxFifoUse = fifoCount;
+      // Limit write time by writing one whole sector at a time.
+      if (fifo.sectors()) {
+        UM7_TRACE_BEGIN(span);
+        uint32_t usec = micros();
+        if (512 != binFile.write(fifo.sector(), 512)) {
+          error("write binFile failed");
+        }
+        usec = micros() - usec;
+        UM7_TRACE_END(span, UM7_TRACE_SD_WRITE, 0, 0, 0);
+        if (usec > maxWriteMicros) {
+          maxWriteMicros = usec;
+        }
+        if (fifo.size() > maxFifoUse) {
+          maxFifoUse = fifo.size();
+        }
+        fifo.pop();
       }
-      fifoCount -= nw;
       if (Serial.available()) {
         break;
       }
@@ -487,7 +743,32 @@ void logData() {
   Serial.print(F("\nLog time: "));
   Serial.print(log_time);
   Serial.println(F(" Seconds"));
-  binFile.truncate();
+#if EVENT_CAPTURE
+  // Save the records of the current event that are still in the ring
+  if (capture) {
+    uint32_t end = saveEnd < head ? saveEnd : head;
+    while (saved < end) {
+      if (fifo.space() < sizeof(data_t)) {
+        if (512 != binFile.write(fifo.sector(), 512)) {
+          error("write binFile failed");
+        }
+        fifo.pop();
+      }
+      fifo.push(&captureRing[saved % CAPTURE_RING_RECORDS], sizeof(data_t));
+      logBytes += sizeof(data_t);
+      saved++;
+    }
+  }
+#endif  // EVENT_CAPTURE
+  // Write out the last partial sector, then cut the file to the last whole record
+  fifo.pad();
+  while (fifo.sectors()) {
+    if (512 != binFile.write(fifo.sector(), 512)) {
+      error("write binFile failed");
+    }
+    fifo.pop();
+  }
+  binFile.truncate(512 + logBytes);
   binFile.sync();
   Serial.print(("File size: "));
   // Warning cast used for print since fileSize is uint64_t.
@@ -495,19 +776,48 @@ void logData() {
   Serial.println(F(" bytes"));
   Serial.print(F("totalOverrun: "));
   Serial.println(totalOverrun);
+#if EVENT_CAPTURE
+  if (capture) {
+    Serial.print(F("events: "));
+    Serial.println(events);
+  }
+#endif  // EVENT_CAPTURE
   Serial.print(F("FIFO_DIM: "));
   Serial.println(FIFO_DIM);
   Serial.print(F("maxFifoUse: "));
-  Serial.println(maxFifoUse);
+  Serial.println(maxFifoUse/sizeof(data_t));
   Serial.print(F("maxLogMicros: "));
   Serial.println(maxLogMicros);
   Serial.print(F("maxWriteMicros: "));
   Serial.println(maxWriteMicros);
+  Serial.print(F("maxGaitMicros: "));
+  Serial.println(maxGaitMicros);
+  Serial.print(F("heel strikes: "));
+  Serial.println(gait.event_count[0]);
   Serial.print(F("Log interval: "));
   Serial.print(LOG_INTERVAL_USEC);
   Serial.print(F(" micros\nmaxDelta: "));
   Serial.print(maxDelta);
   Serial.println(F(" micros"));
+  printErrors(&imu1, 1);
+  printErrors(&imu2, 2);
+  printErrors(&imu3, 3);
+}
+//------------------------------------------------------------------------------
+// Prints the validation error counters of an imu
+void printErrors(MYUM7SPI* imu, int n) {
+  Serial.print(F("IMU "));
+  Serial.print(n);
+  Serial.print(F(" errors - NaN: "));
+  Serial.print(imu->error_count[0]);
+  Serial.print(F(", range: "));
+  Serial.print(imu->error_count[1]);
+  Serial.print(F(", time: "));
+  Serial.print(imu->error_count[2]);
+  Serial.print(F(", health: "));
+  Serial.print(imu->error_count[3]);
+  Serial.print(F(", re-reads: "));
+  Serial.println(imu->reread_count);
 }
 //------------------------------------------------------------------------------
 void openBinFile() {
@@ -595,13 +905,23 @@ void testSensor() {
   Serial.println(F("\nTesting - type any character to stop\n"));
   delay(1000);
   printRecord(&Serial, nullptr, test);
+  t0 = micros();
+  fsr.start();
+  gait.reset();
+#if DECIMATION_STAGES
+  decimator.reset();
+  decimatorFlags = 0;
+#endif
   uint32_t m = micros();
   while (!Serial.available()) {
     m += interval;
     do {
       diff = m - micros();
     } while (diff > 0);
-    logRecord(&data);
+    // Decimated records need all their samples
+    while (!logRecord(&data)) {
+      delayMicroseconds(SAMPLE_INTERVAL_USEC);
+    }
     printRecord(&Serial, &data, test);
   }
 }
@@ -654,8 +974,14 @@ void loop() {
   Serial.println(F("c - convert file to csv"));
   Serial.println(F("l - list files"));
   Serial.println(F("p - print data to Serial"));
+#if EVENT_CAPTURE
+  Serial.println(F("e - record trigger events only"));
+#endif
   Serial.println(F("r - record data"));
   Serial.println(F("t - test without logging"));
+#if UM7_TRACE
+  Serial.println(F("d - dump SPI trace of the last log"));
+#endif
   while(!Serial.available()) {
     SysCall::yield();
   }
@@ -676,8 +1002,23 @@ void loop() {
 	test = false;
     printData();
   } else if (c == 'r') {
+    imu1.clear_errors();
+    imu2.clear_errors();
+    imu3.clear_errors();
+    createBinFile();
+    logData(false);
+#if EVENT_CAPTURE
+  } else if (c == 'e') {
+    imu1.clear_errors();
+    imu2.clear_errors();
+    imu3.clear_errors();
     createBinFile();
-    logData();
+    logData(true);
+#endif
+#if UM7_TRACE
+  } else if (c == 'd') {
+    um7_trace.dump(&Serial);
+#endif
   } else if (c == 't') {
 	test = true;
     testSensor();
@@ -694,6 +1035,7 @@ void setup_imus(byte rate_) {
   // Init the analog sensors
   pinMode(fsr_heel_pin, INPUT);
   pinMode(fsr_toe_pin, INPUT);
+  fsr.begin(fsr_heel_pin, fsr_toe_pin);
   // Init the SPI bus used for UM7s at default rate
   SPI.begin();
   // Default SPI0 pins:
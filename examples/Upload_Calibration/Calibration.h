@@ -0,0 +1,9 @@
+// Calibration to upload, replace this file with the <name>_cal.h written by
+// extras/host/um7_calibrate for the sensor on the bench.
+// All zero means no calibration yet, the sketch refuses to upload it.
+const um7_calibration_t UM7_CALIBRATION = {
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0 }, // mag_cal
+	{ 0, 0, 0 }, // mag_bias
+	{ 0, 0, 0, 0, 0, 0, 0, 0, 0 }, // accel_cal
+	{ 0, 0, 0 }, // accel_bias
+};
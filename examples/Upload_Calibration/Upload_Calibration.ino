@@ -0,0 +1,116 @@
+/* Arduino Example for calibrating the UM7 magnetometer and accelerometer
+ *
+ * Ben Milligan, 2020
+ *
+ * 1. 'd' streams raw accel and mag counts as csv. Capture it to a file
+ *    while slowly turning the sensor through every orientation, then stop
+ *    with any character.
+ * 2. Run extras/host/um7_calibrate on the file and copy the <name>_cal.h
+ *    it writes over Calibration.h, then upload this sketch again.
+ * 3. 'w' writes all calibration registers, reads them back and saves them
+ *    to FLASH with a single flash_commit() once every one verified.
+ *
+ * 'p' prints the calibration registers currently in use.
+ *
+ * Tested on:
+ * - [180MHz] Teensy 3.6
+ */
+#include <MYUM7SPI.h>
+#include "Calibration.h"
+
+#if !UM7_STORE_RAW
+#error Set UM7_STORE_RAW to 1 in MYUM7SPIConfig.h
+#endif
+
+// Interval between raw samples in microseconds, 10000 usec = 100Hz
+const uint32_t SAMPLE_INTERVAL_USEC = 10000;
+
+// Init the um7 at 10MHz
+MYUM7SPI imu1(6, 10000000); // cs pin
+
+void serialClearInput() {
+  do {
+    delay(10);
+  } while (Serial.read() >= 0);
+}
+
+void printCalibration(const um7_calibration_t& cal) {
+  const float* v = (const float*)&cal;
+  const char* names[4] = { "MAG CAL", "MAG BIAS", "ACCEL CAL", "ACCEL BIAS" };
+  const int sizes[4] = { 9, 3, 9, 3 };
+  for (int g = 0; g < 4; g++) {
+    Serial.print(names[g]);
+    for (int i = 0; i < sizes[g]; i++) {
+      Serial.print(",");
+      Serial.print(*v++, 9);
+    }
+    Serial.println();
+  }
+}
+
+void dumpRaw() {
+  uint32_t n = 0;
+  serialClearInput();
+  Serial.println(F("TRANSFER #,AX RAW,AY RAW,AZ RAW,MX RAW,MY RAW,MZ RAW"));
+  uint32_t next = micros();
+  while (!Serial.available()) {
+    while ((int32_t)(micros() - next) < 0);
+    next += SAMPLE_INTERVAL_USEC;
+    imu1.get_all_raw_data();
+    // Skip samples that failed validation
+    if (imu1.sample_flags) continue;
+    Serial.print(n++); Serial.print(",");
+    Serial.print(imu1.accel_raw_x); Serial.print(",");
+    Serial.print(imu1.accel_raw_y); Serial.print(",");
+    Serial.print(imu1.accel_raw_z); Serial.print(",");
+    Serial.print(imu1.mag_raw_x); Serial.print(",");
+    Serial.print(imu1.mag_raw_y); Serial.print(",");
+    Serial.println(imu1.mag_raw_z);
+  }
+}
+
+void writeCalibration() {
+  if (UM7_CALIBRATION.mag_cal[0] == 0 || UM7_CALIBRATION.accel_cal[0] == 0) {
+    Serial.println(F("No calibration in Calibration.h, run um7_calibrate first"));
+    return;
+  }
+  if (imu1.write_calibration(UM7_CALIBRATION, true)) {
+    Serial.println(F("Calibration verified and saved to FLASH"));
+  } else {
+    Serial.println(F("Read back failed, nothing saved. Check the wiring and try again"));
+  }
+}
+
+void setup() {
+  Serial.begin(115200);
+  while (!Serial); // Serial acts as a on switch
+
+  SPI.begin();
+
+  // Raw registers are only updated at the raw rate
+  imu1.set_all_raw_rate(100);
+  delay(100);
+}
+
+void loop() {
+  serialClearInput();
+  Serial.println();
+  Serial.println(F("type: "));
+  Serial.println(F("d - dump raw samples as csv"));
+  Serial.println(F("p - print calibration registers"));
+  Serial.println(F("w - write Calibration.h and save to FLASH"));
+  while (!Serial.available());
+  char c = tolower(Serial.read());
+
+  if (c == 'd') {
+    dumpRaw();
+  } else if (c == 'p') {
+    um7_calibration_t cal;
+    imu1.read_calibration(cal);
+    printCalibration(cal);
+  } else if (c == 'w') {
+    writeCalibration();
+  } else {
+    Serial.println(F("Invalid entry"));
+  }
+}
@@ -0,0 +1,49 @@
+/*
+
+Lock-free single producer / single consumer ring buffer for the host tools.
+
+Capacity must be a power of two. One thread may push() and one other thread
+may pop() without any locking; push() fails instead of blocking when full so
+the serial reader never stalls behind a slow consumer.
+
+*/
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+template <typename T, size_t N>
+class SpscQueue {
+	static_assert((N & (N - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+	bool push(const T& v) {
+		size_t head = head_.load(std::memory_order_relaxed);
+		if (head - tail_.load(std::memory_order_acquire) == N) return false;
+		buf_[head & (N - 1)] = v;
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	bool pop(T& v) {
+		size_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail == head_.load(std::memory_order_acquire)) return false;
+		v = buf_[tail & (N - 1)];
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	size_t size() const {
+		return head_.load(std::memory_order_acquire) - tail_.load(std::memory_order_acquire);
+	}
+
+private:
+	T buf_[N];
+	// Keep the indices on separate cache lines so producer and consumer don't false share
+	alignas(64) std::atomic<size_t> head_{0};
+	alignas(64) std::atomic<size_t> tail_{0};
+};
+
+#endif
@@ -0,0 +1,256 @@
+/*
+
+Sparse time index for the SD logger .bin files.
+See um7_bin_index.h.
+
+*/
+
+#include "um7_bin_index.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+// Index file layout: magic, then the fixed header fields, then the entries and gaps.
+// Written in host byte order, the files are only read back on the machine that made them.
+static const char IDX_MAGIC[8] = { 'U', 'M', '7', 'I', 'D', 'X', '1', 0 };
+
+// Records read per fread while scanning
+#define SCAN_RECORDS 8192
+
+static uint32_t record_time(const uint8_t* rec) {
+	uint32_t t;
+	memcpy(&t, rec, sizeof(t));
+	return t;
+}
+
+static bool all_zero(const uint8_t* rec, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		if (rec[i]) return false;
+	}
+	return true;
+}
+
+static uint64_t file_size(FILE* f) {
+	fseeko(f, 0, SEEK_END);
+	uint64_t n = ftello(f);
+	fseeko(f, 0, SEEK_SET);
+	return n;
+}
+
+const um7_index_entry_t& um7_bin_index_t::seek(uint64_t t_us) const {
+	// entries is never empty for a non-empty session, entry 0 is record 0 at t = 0
+	std::vector<um7_index_entry_t>::const_iterator it = std::upper_bound(entries.begin(), entries.end(), t_us,
+		[](uint64_t t, const um7_index_entry_t& e) { return t < e.t_us; });
+	return it == entries.begin() ? *it : *(it - 1);
+}
+
+bool um7_index_build(const std::string& bin_path, uint32_t record_size, uint32_t every, uint32_t max_gap_us,
+	um7_bin_index_t& idx, std::string& err) {
+	if (record_size < sizeof(uint32_t) || every == 0) {
+		err = bin_path + ": bad record size or entry spacing";
+		return false;
+	}
+	FILE* f = fopen(bin_path.c_str(), "rb");
+	if (!f) {
+		err = bin_path + ": cannot open";
+		return false;
+	}
+	idx = um7_bin_index_t();
+	idx.record_size = record_size;
+	idx.every = every;
+	idx.max_gap_us = max_gap_us;
+	idx.t0 = 0;
+	idx.bin_size = file_size(f);
+	idx.records = 0;
+	idx.duration_us = 0;
+	if (fseeko(f, UM7_INDEX_DATA_OFFSET, SEEK_SET) != 0) {
+		fclose(f);
+		return true;
+	}
+
+	std::vector<uint8_t> buf((size_t)SCAN_RECORDS * record_size);
+	uint64_t t_us = 0;
+	uint32_t t_last = 0;
+	bool done = false, zero_tail = false;
+	while (!done) {
+		size_t nr = fread(buf.data(), record_size, SCAN_RECORDS, f);
+		if (nr == 0) break;
+		for (size_t i = 0; i < nr; i++) {
+			const uint8_t* rec = &buf[i * record_size];
+			if (all_zero(rec, record_size)) {
+				done = zero_tail = true;
+				break;
+			}
+			uint32_t t = record_time(rec);
+			uint64_t n = idx.records;
+			if (n == 0) {
+				idx.t0 = t;
+			} else {
+				// Unsigned difference handles the 32 bit wrap
+				uint32_t delta = t - t_last;
+				t_us += delta;
+				if (delta >= max_gap_us) {
+					idx.gaps.push_back({ n, t_us - delta, t_us });
+					// Seeks into the span after a gap land on its first record
+					if (n % every) idx.entries.push_back({ t_us, n });
+				}
+			}
+			if (n % every == 0) idx.entries.push_back({ t_us, n });
+			t_last = t;
+			idx.records++;
+		}
+		if (nr < SCAN_RECORDS) break;
+	}
+	if (ferror(f)) {
+		fclose(f);
+		err = bin_path + ": read failed";
+		return false;
+	}
+	fclose(f);
+	// The loggers truncate to whole records on stop, only a preallocated tail (lost power) may end
+	// mid-record. Anything else means the file was written with another data_t.
+	if (!zero_tail && (idx.bin_size - UM7_INDEX_DATA_OFFSET) % record_size != 0) {
+		err = bin_path + ": not a whole number of " + std::to_string(record_size) + " Byte records, wrong record size?";
+		return false;
+	}
+	idx.duration_us = t_us;
+	return true;
+}
+
+bool um7_index_save(const std::string& idx_path, const um7_bin_index_t& idx, std::string& err) {
+	FILE* f = fopen(idx_path.c_str(), "wb");
+	if (!f) {
+		err = idx_path + ": cannot create";
+		return false;
+	}
+	uint64_t n_entries = idx.entries.size();
+	uint64_t n_gaps = idx.gaps.size();
+	bool ok = fwrite(IDX_MAGIC, sizeof(IDX_MAGIC), 1, f) == 1
+		&& fwrite(&idx.record_size, sizeof(idx.record_size), 1, f) == 1
+		&& fwrite(&idx.every, sizeof(idx.every), 1, f) == 1
+		&& fwrite(&idx.max_gap_us, sizeof(idx.max_gap_us), 1, f) == 1
+		&& fwrite(&idx.t0, sizeof(idx.t0), 1, f) == 1
+		&& fwrite(&idx.bin_size, sizeof(idx.bin_size), 1, f) == 1
+		&& fwrite(&idx.records, sizeof(idx.records), 1, f) == 1
+		&& fwrite(&idx.duration_us, sizeof(idx.duration_us), 1, f) == 1
+		&& fwrite(&n_entries, sizeof(n_entries), 1, f) == 1
+		&& fwrite(&n_gaps, sizeof(n_gaps), 1, f) == 1
+		&& fwrite(idx.entries.data(), sizeof(um7_index_entry_t), n_entries, f) == n_entries
+		&& fwrite(idx.gaps.data(), sizeof(um7_index_gap_t), n_gaps, f) == n_gaps;
+	if (fclose(f) != 0) ok = false;
+	if (!ok) {
+		err = idx_path + ": write failed";
+		remove(idx_path.c_str());
+	}
+	return ok;
+}
+
+bool um7_index_load(const std::string& idx_path, um7_bin_index_t& idx, std::string& err) {
+	FILE* f = fopen(idx_path.c_str(), "rb");
+	if (!f) {
+		err = idx_path + ": cannot open";
+		return false;
+	}
+	char magic[sizeof(IDX_MAGIC)];
+	uint64_t n_entries = 0, n_gaps = 0;
+	idx = um7_bin_index_t();
+	bool ok = fread(magic, sizeof(magic), 1, f) == 1 && memcmp(magic, IDX_MAGIC, sizeof(magic)) == 0
+		&& fread(&idx.record_size, sizeof(idx.record_size), 1, f) == 1
+		&& fread(&idx.every, sizeof(idx.every), 1, f) == 1
+		&& fread(&idx.max_gap_us, sizeof(idx.max_gap_us), 1, f) == 1
+		&& fread(&idx.t0, sizeof(idx.t0), 1, f) == 1
+		&& fread(&idx.bin_size, sizeof(idx.bin_size), 1, f) == 1
+		&& fread(&idx.records, sizeof(idx.records), 1, f) == 1
+		&& fread(&idx.duration_us, sizeof(idx.duration_us), 1, f) == 1
+		&& fread(&n_entries, sizeof(n_entries), 1, f) == 1
+		&& fread(&n_gaps, sizeof(n_gaps), 1, f) == 1
+		&& n_entries <= idx.records && n_gaps <= idx.records;
+	if (ok) {
+		idx.entries.resize(n_entries);
+		idx.gaps.resize(n_gaps);
+		ok = fread(idx.entries.data(), sizeof(um7_index_entry_t), n_entries, f) == n_entries
+			&& fread(idx.gaps.data(), sizeof(um7_index_gap_t), n_gaps, f) == n_gaps;
+	}
+	fclose(f);
+	if (!ok) err = idx_path + ": not a valid index";
+	return ok;
+}
+
+bool um7_index_open(const std::string& bin_path, uint32_t record_size, uint32_t every, uint32_t max_gap_us,
+	um7_bin_index_t& idx, std::string& err) {
+	std::string idx_path = bin_path + ".idx";
+	FILE* f = fopen(bin_path.c_str(), "rb");
+	if (!f) {
+		err = bin_path + ": cannot open";
+		return false;
+	}
+	uint64_t size = file_size(f);
+	fclose(f);
+
+	std::string load_err;
+	if (um7_index_load(idx_path, idx, load_err) && idx.bin_size == size
+		&& idx.record_size == record_size && idx.every == every && idx.max_gap_us == max_gap_us) {
+		return true;
+	}
+	if (!um7_index_build(bin_path, record_size, every, max_gap_us, idx, err)) return false;
+	// A read-only session directory still works, just without the saved index
+	um7_index_save(idx_path, idx, load_err);
+	return true;
+}
+
+bool um7_index_read_window(const std::string& bin_path, const um7_bin_index_t& idx, uint64_t from_us, uint64_t to_us,
+	std::vector<uint8_t>& out, uint64_t& first, std::string& err) {
+	out.clear();
+	first = 0;
+	if (idx.records == 0 || from_us >= to_us || from_us > idx.duration_us) return true;
+
+	FILE* f = fopen(bin_path.c_str(), "rb");
+	if (!f) {
+		err = bin_path + ": cannot open";
+		return false;
+	}
+	const um7_index_entry_t& e = idx.seek(from_us);
+	if (fseeko(f, idx.offset(e.record), SEEK_SET) != 0) {
+		fclose(f);
+		err = bin_path + ": seek failed";
+		return false;
+	}
+
+	size_t rs = idx.record_size;
+	std::vector<uint8_t> buf((size_t)SCAN_RECORDS * rs);
+	uint64_t n = e.record;
+	uint64_t t_us = e.t_us;
+	uint32_t t_last = (uint32_t)(idx.t0 + e.t_us);
+	bool found = false;
+	while (n < idx.records) {
+		uint64_t want = std::min<uint64_t>(SCAN_RECORDS, idx.records - n);
+		size_t nr = fread(buf.data(), rs, want, f);
+		if (nr == 0) break;
+		for (size_t i = 0; i < nr; i++, n++) {
+			const uint8_t* rec = &buf[i * rs];
+			uint32_t t = record_time(rec);
+			t_us += (uint32_t)(t - t_last);
+			t_last = t;
+			if (t_us >= to_us) {
+				fclose(f);
+				return true;
+			}
+			if (t_us >= from_us) {
+				if (!found) {
+					found = true;
+					first = n;
+				}
+				out.insert(out.end(), rec, rec + rs);
+			}
+		}
+		if (nr < want) break;
+	}
+	bool failed = ferror(f);
+	fclose(f);
+	if (failed) {
+		err = bin_path + ": read failed";
+		return false;
+	}
+	return true;
+}
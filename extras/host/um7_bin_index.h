@@ -0,0 +1,80 @@
+/*
+
+Sparse time index for the .bin files written by the SD logger examples.
+
+A .bin file is one dummy sector followed by data_t records back to back
+(UM7SectorFifo.h), each starting with the uint32 micros() time "t". The
+index keeps the unwrapped time of every Nth record plus every record that
+follows a missed packet gap, so a reader can binary search the index,
+seek to the nearest entry before the time it wants and scan at most N
+records instead of the whole (often multi-GB) file.
+
+Times in the index are microseconds since the first record of the session,
+unwrapped to 64 bits (t wraps after ~71 minutes). The raw t of a record is
+(uint32_t)(t0 + t_us).
+
+The index is saved next to the .bin as "<name>.bin.idx". It records the
+size of the .bin it was built from, um7_index_open() rebuilds it when the
+.bin, the record size or the entry spacing changed.
+
+*/
+
+#ifndef UM7_BIN_INDEX_H
+#define UM7_BIN_INDEX_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "UM7LogFormat.h"
+
+// First record of a .bin follows one dummy sector
+#define UM7_INDEX_DATA_OFFSET UM7_LOG_DATA_OFFSET
+
+struct um7_index_entry_t {
+	uint64_t t_us;   // since the first record
+	uint64_t record; // record number, the file offset is UM7_INDEX_DATA_OFFSET + record * record_size
+};
+
+// Missed packet gap, "record" is the first record after it
+struct um7_index_gap_t {
+	uint64_t record;
+	uint64_t t_before_us, t_after_us;
+};
+
+struct um7_bin_index_t {
+	uint32_t record_size;
+	uint32_t every;      // records between entries
+	uint32_t max_gap_us; // deltas at or above this are gaps (MAX_INTERVAL_USEC in the loggers)
+	uint32_t t0;         // raw t of the first record
+	uint64_t bin_size;   // size of the .bin when indexed
+	uint64_t records;
+	uint64_t duration_us;
+	std::vector<um7_index_entry_t> entries;
+	std::vector<um7_index_gap_t> gaps;
+
+	uint64_t offset(uint64_t record) const { return UM7_INDEX_DATA_OFFSET + record * record_size; }
+
+	// Last entry at or before t_us, the place to start scanning for t_us
+	const um7_index_entry_t& seek(uint64_t t_us) const;
+};
+
+// Scans "bin_path" and builds its index. Stops at the end of the file or at an all zero
+// record (the unused preallocated tail left by a logger that lost power). Fails if the
+// records don't fill the file exactly, which is what a wrong record_size looks like.
+bool um7_index_build(const std::string& bin_path, uint32_t record_size, uint32_t every, uint32_t max_gap_us,
+	um7_bin_index_t& idx, std::string& err);
+
+bool um7_index_save(const std::string& idx_path, const um7_bin_index_t& idx, std::string& err);
+bool um7_index_load(const std::string& idx_path, um7_bin_index_t& idx, std::string& err);
+
+// Loads "<bin_path>.idx", or builds and saves it if it's missing, stale or for another record size
+bool um7_index_open(const std::string& bin_path, uint32_t record_size, uint32_t every, uint32_t max_gap_us,
+	um7_bin_index_t& idx, std::string& err);
+
+// Reads the records with from_us <= t < to_us into "out" (raw, record_size bytes each).
+// "first" is set to the record number of the first one.
+bool um7_index_read_window(const std::string& bin_path, const um7_bin_index_t& idx, uint64_t from_us, uint64_t to_us,
+	std::vector<uint8_t>& out, uint64_t& first, std::string& err);
+
+#endif
@@ -0,0 +1,180 @@
+/*
+
+Magnetometer and accelerometer calibration from logged raw samples.
+
+Reads the csv written by examples/Upload_Calibration ('d' command, raw
+counts from get_all_raw_data() while the sensor is turned through all
+orientations), fits an ellipsoid to the accelerometer and to the
+magnetometer samples (um7_ellipsoid.h) and writes a header with the
+um7_calibration_t for MYUM7SPI::write_calibration(). One file per sensor,
+any number of sensors per run.
+
+Build:
+  g++ -O3 -march=native -std=c++17 -pthread um7_calibrate.cpp um7_ellipsoid.cpp -o um7_calibrate
+
+Usage:
+  ./um7_calibrate [options] sensor1.csv sensor2.csv ... > summary.csv
+
+Options:
+  --accel-radius R    Length of a corrected accel sample (default 1, G)
+  --mag-radius R      Length of a corrected mag sample (default 1, normalized)
+  --threads N         Threads per fit (default all cores)
+  --out-dir DIR       Where the headers go (default next to each csv)
+
+Writes "<name>_cal.h" for every input. Copy it over Calibration.h in
+examples/Upload_Calibration to upload it.
+
+Output columns:
+  FILE,SENSOR,SAMPLES,BIAS X,BIAS Y,BIAS Z,RADIUS MAX,RADIUS MIN,RMS %
+
+*/
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "um7_ellipsoid.h"
+
+struct options_t {
+	double accel_radius = 1.0, mag_radius = 1.0;
+	unsigned threads = 0;
+	std::string out_dir;
+	std::vector<std::string> files;
+};
+
+// Raw columns of the csv, accel then mag
+static const char* COLUMNS[6] = { "AX RAW", "AY RAW", "AZ RAW", "MX RAW", "MY RAW", "MZ RAW" };
+
+// Loads the six raw columns. Lines before the header and non-numeric lines are skipped.
+static bool load_raw(const std::string& path, std::vector<float> (&cols)[6], std::string& err) {
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) {
+		err = path + ": cannot open";
+		return false;
+	}
+	int index[6] = { -1, -1, -1, -1, -1, -1 };
+	bool header = false;
+	char line[1024];
+	std::vector<char*> fields;
+	while (fgets(line, sizeof(line), f)) {
+		line[strcspn(line, "\r\n")] = 0;
+		fields.clear();
+		fields.push_back(line);
+		for (char* p = line; *p; p++) {
+			if (*p == ',') {
+				*p = 0;
+				fields.push_back(p + 1);
+			}
+		}
+		if (!header) {
+			for (size_t i = 0; i < fields.size(); i++) {
+				for (int c = 0; c < 6; c++) {
+					if (strcmp(fields[i], COLUMNS[c]) == 0) index[c] = (int)i;
+				}
+			}
+			header = index[0] >= 0;
+			continue;
+		}
+		char c0 = fields[0][0];
+		if (!((c0 >= '0' && c0 <= '9') || c0 == '-')) continue;
+		bool ok = true;
+		float v[6];
+		for (int c = 0; c < 6 && ok; c++) {
+			ok = index[c] >= 0 && index[c] < (int)fields.size();
+			if (ok) v[c] = strtof(fields[index[c]], nullptr);
+		}
+		if (!ok) continue;
+		for (int c = 0; c < 6; c++) cols[c].push_back(v[c]);
+	}
+	fclose(f);
+	for (int c = 0; c < 6; c++) {
+		if (index[c] < 0) {
+			err = path + ": no " + COLUMNS[c] + " column";
+			return false;
+		}
+	}
+	return true;
+}
+
+static void print_row(FILE* out, const double* v, int n, const char* comment) {
+	fprintf(out, "\t{");
+	for (int i = 0; i < n; i++) fprintf(out, "%s%.9gf", i ? ", " : " ", v[i]);
+	fprintf(out, " }, // %s\n", comment);
+}
+
+static bool write_header(const std::string& name, const std::string& source, const um7_ellipsoid_fit_t& mag,
+	const um7_ellipsoid_fit_t& accel, std::string& err) {
+	FILE* out = fopen(name.c_str(), "w");
+	if (!out) {
+		err = name + ": cannot create";
+		return false;
+	}
+	std::string base = source.substr(source.find_last_of('/') + 1);
+	fprintf(out, "// Generated by um7_calibrate from %s\n", base.c_str());
+	fprintf(out, "// accel: %zu samples, %.3f%% rms, mag: %zu samples, %.3f%% rms\n",
+		accel.samples, accel.rms * 100, mag.samples, mag.rms * 100);
+	fprintf(out, "const um7_calibration_t UM7_CALIBRATION = {\n");
+	print_row(out, mag.cal, 9, "mag_cal");
+	print_row(out, mag.bias, 3, "mag_bias");
+	print_row(out, accel.cal, 9, "accel_cal");
+	print_row(out, accel.bias, 3, "accel_bias");
+	fprintf(out, "};\n");
+	if (fclose(out) != 0) {
+		err = name + ": write failed";
+		return false;
+	}
+	return true;
+}
+
+int main(int argc, char** argv) {
+	options_t opt;
+	for (int i = 1; i < argc; i++) {
+		std::string a = argv[i];
+		bool has_val = i + 1 < argc;
+		if (a == "--accel-radius" && has_val) opt.accel_radius = strtod(argv[++i], nullptr);
+		else if (a == "--mag-radius" && has_val) opt.mag_radius = strtod(argv[++i], nullptr);
+		else if (a == "--threads" && has_val) opt.threads = atoi(argv[++i]);
+		else if (a == "--out-dir" && has_val) opt.out_dir = argv[++i];
+		else if (a.compare(0, 2, "--") == 0) {
+			fprintf(stderr, "unknown option %s\n", a.c_str());
+			return 1;
+		} else opt.files.push_back(a);
+	}
+	if (opt.files.empty()) {
+		fprintf(stderr, "usage: %s [options] sensor.csv ...\n", argv[0]);
+		return 1;
+	}
+
+	printf("FILE,SENSOR,SAMPLES,BIAS X,BIAS Y,BIAS Z,RADIUS MAX,RADIUS MIN,RMS %%\n");
+	int status = 0;
+	for (const std::string& path : opt.files) {
+		std::vector<float> cols[6];
+		std::string err;
+		um7_ellipsoid_fit_t fit[2];
+		bool ok = load_raw(path, cols, err);
+		for (int s = 0; s < 2 && ok; s++) {
+			double radius = s == 0 ? opt.accel_radius : opt.mag_radius;
+			ok = um7_fit_ellipsoid(cols[s * 3].data(), cols[s * 3 + 1].data(), cols[s * 3 + 2].data(),
+				cols[s * 3].size(), radius, opt.threads, fit[s], err);
+			if (!ok) err = path + (s == 0 ? ": accel: " : ": mag: ") + err;
+		}
+		if (ok) {
+			std::string base = path.substr(0, path.find_last_of('.'));
+			if (!opt.out_dir.empty()) base = opt.out_dir + "/" + base.substr(base.find_last_of('/') + 1);
+			ok = write_header(base + "_cal.h", path, fit[1], fit[0], err);
+		}
+		if (!ok) {
+			fprintf(stderr, "%s\n", err.c_str());
+			status = 1;
+			continue;
+		}
+		for (int s = 0; s < 2; s++) {
+			const um7_ellipsoid_fit_t& f = fit[s];
+			printf("%s,%s,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.4f\n", path.c_str(), s == 0 ? "accel" : "mag", f.samples,
+				f.bias[0], f.bias[1], f.bias[2], f.radii[0], f.radii[2], f.rms * 100);
+		}
+	}
+	return status;
+}
@@ -0,0 +1,248 @@
+/*
+
+Least squares ellipsoid fit. See um7_ellipsoid.h.
+
+*/
+
+#include "um7_ellipsoid.h"
+
+#include <cmath>
+#include <thread>
+#include <vector>
+
+// Upper triangle of the 9x9 normal matrix, then the right hand side
+#define N_TERMS 9
+#define N_UPPER (N_TERMS * (N_TERMS + 1) / 2)
+
+struct moments_t {
+	double ata[N_UPPER];
+	double atb[N_TERMS];
+};
+
+// Runs fn(begin, end, block) on "blocks" contiguous blocks of [0, n), one thread each
+template <typename F>
+static void parallel_blocks(size_t n, unsigned blocks, F fn) {
+	std::vector<std::thread> workers;
+	for (unsigned b = 0; b < blocks; b++) {
+		size_t begin = n * b / blocks, end = n * (b + 1) / blocks;
+		workers.emplace_back([=]() { fn(begin, end, b); });
+	}
+	for (std::thread& t : workers) t.join();
+}
+
+// Sums the normal equations of the samples in [begin, end), in coordinates centered on
+// "mean" and divided by "scale" so the terms are all about 1.
+static void accumulate(const float* x, const float* y, const float* z, size_t begin, size_t end,
+	const double* mean, double scale, moments_t& m) {
+	double ata[N_UPPER] = { 0 };
+	double atb[N_TERMS] = { 0 };
+	const double s = 1.0 / scale;
+	for (size_t i = begin; i < end; i++) {
+		double px = (x[i] - mean[0]) * s, py = (y[i] - mean[1]) * s, pz = (z[i] - mean[2]) * s;
+		double r[N_TERMS] = { px * px, py * py, pz * pz, 2 * px * py, 2 * px * pz, 2 * py * pz, 2 * px, 2 * py, 2 * pz };
+		int k = 0;
+		for (int a = 0; a < N_TERMS; a++) {
+			atb[a] += r[a];
+			for (int b = a; b < N_TERMS; b++) ata[k++] += r[a] * r[b];
+		}
+	}
+	for (int k = 0; k < N_UPPER; k++) m.ata[k] = ata[k];
+	for (int a = 0; a < N_TERMS; a++) m.atb[a] = atb[a];
+}
+
+// Solves the symmetric positive definite system in place, "a" is full n x n row major
+static bool cholesky_solve(double* a, double* b, int n) {
+	for (int j = 0; j < n; j++) {
+		double d = a[j * n + j];
+		for (int k = 0; k < j; k++) d -= a[j * n + k] * a[j * n + k];
+		if (d <= 0.0) return false;
+		d = sqrt(d);
+		a[j * n + j] = d;
+		for (int i = j + 1; i < n; i++) {
+			double v = a[i * n + j];
+			for (int k = 0; k < j; k++) v -= a[i * n + k] * a[j * n + k];
+			a[i * n + j] = v / d;
+		}
+	}
+	for (int i = 0; i < n; i++) {
+		double v = b[i];
+		for (int k = 0; k < i; k++) v -= a[i * n + k] * b[k];
+		b[i] = v / a[i * n + i];
+	}
+	for (int i = n - 1; i >= 0; i--) {
+		double v = b[i];
+		for (int k = i + 1; k < n; k++) v -= a[k * n + i] * b[k];
+		b[i] = v / a[i * n + i];
+	}
+	return true;
+}
+
+// Eigen decomposition of a symmetric 3x3 matrix by Jacobi rotations.
+// "m" is overwritten, eigenvalues end up in "w" and eigenvectors in the columns of "v".
+static void jacobi3(double m[3][3], double w[3], double v[3][3]) {
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) v[i][j] = i == j;
+	}
+	for (int sweep = 0; sweep < 50; sweep++) {
+		double off = m[0][1] * m[0][1] + m[0][2] * m[0][2] + m[1][2] * m[1][2];
+		if (off < 1e-30) break;
+		for (int p = 0; p < 2; p++) {
+			for (int q = p + 1; q < 3; q++) {
+				if (m[p][q] == 0.0) continue;
+				double theta = (m[q][q] - m[p][p]) / (2 * m[p][q]);
+				double t = (theta >= 0 ? 1.0 : -1.0) / (fabs(theta) + sqrt(theta * theta + 1));
+				double c = 1 / sqrt(t * t + 1), s = t * c;
+				for (int k = 0; k < 3; k++) {
+					double mkp = m[k][p], mkq = m[k][q];
+					m[k][p] = c * mkp - s * mkq;
+					m[k][q] = s * mkp + c * mkq;
+				}
+				for (int k = 0; k < 3; k++) {
+					double mpk = m[p][k], mqk = m[q][k];
+					m[p][k] = c * mpk - s * mqk;
+					m[q][k] = s * mpk + c * mqk;
+				}
+				for (int k = 0; k < 3; k++) {
+					double vkp = v[k][p], vkq = v[k][q];
+					v[k][p] = c * vkp - s * vkq;
+					v[k][q] = s * vkp + c * vkq;
+				}
+			}
+		}
+	}
+	for (int i = 0; i < 3; i++) w[i] = m[i][i];
+}
+
+bool um7_fit_ellipsoid(const float* x, const float* y, const float* z, size_t n, double radius, unsigned threads,
+	um7_ellipsoid_fit_t& fit, std::string& err) {
+	fit = um7_ellipsoid_fit_t();
+	fit.samples = n;
+	if (n < N_TERMS * 4) {
+		err = "too few samples";
+		return false;
+	}
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	// Blocks under ~64k samples aren't worth a thread
+	if (threads > n / 65536 + 1) threads = n / 65536 + 1;
+
+	// Pass 1: mean and spread, for conditioning
+	std::vector<double> part(threads * 4, 0.0);
+	parallel_blocks(n, threads, [&](size_t begin, size_t end, unsigned b) {
+		double sx = 0, sy = 0, sz = 0, ss = 0;
+		for (size_t i = begin; i < end; i++) {
+			sx += x[i];
+			sy += y[i];
+			sz += z[i];
+			ss += (double)x[i] * x[i] + (double)y[i] * y[i] + (double)z[i] * z[i];
+		}
+		part[b * 4 + 0] = sx;
+		part[b * 4 + 1] = sy;
+		part[b * 4 + 2] = sz;
+		part[b * 4 + 3] = ss;
+	});
+	double mean[3] = { 0, 0, 0 }, ss = 0;
+	for (unsigned b = 0; b < threads; b++) {
+		for (int k = 0; k < 3; k++) mean[k] += part[b * 4 + k];
+		ss += part[b * 4 + 3];
+	}
+	for (int k = 0; k < 3; k++) mean[k] /= n;
+	double scale = sqrt(ss / n - mean[0] * mean[0] - mean[1] * mean[1] - mean[2] * mean[2]);
+	if (!(scale > 0)) {
+		err = "samples don't vary";
+		return false;
+	}
+
+	// Pass 2: normal equations
+	std::vector<moments_t> moments(threads);
+	parallel_blocks(n, threads, [&](size_t begin, size_t end, unsigned b) {
+		accumulate(x, y, z, begin, end, mean, scale, moments[b]);
+	});
+	double ata[N_TERMS * N_TERMS], p[N_TERMS] = { 0 };
+	for (int k = 0; k < N_TERMS * N_TERMS; k++) ata[k] = 0;
+	for (unsigned b = 0; b < threads; b++) {
+		int k = 0;
+		for (int i = 0; i < N_TERMS; i++) {
+			p[i] += moments[b].atb[i];
+			for (int j = i; j < N_TERMS; j++, k++) {
+				ata[i * N_TERMS + j] += moments[b].ata[k];
+				if (j != i) ata[j * N_TERMS + i] += moments[b].ata[k];
+			}
+		}
+	}
+	if (!cholesky_solve(ata, p, N_TERMS)) {
+		err = "singular fit, turn the sensor through more orientations";
+		return false;
+	}
+
+	// Center c = -Q^-1 g, then the shape M = Q / (1 + c' Q c) in normalized units
+	double q[3][3] = { { p[0], p[3], p[4] }, { p[3], p[1], p[5] }, { p[4], p[5], p[2] } };
+	double g[3] = { p[6], p[7], p[8] };
+	double w[3], v[3][3], qm[3][3];
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) qm[i][j] = q[i][j];
+	}
+	jacobi3(qm, w, v);
+	if (w[0] <= 0 || w[1] <= 0 || w[2] <= 0) {
+		err = "samples don't lie on an ellipsoid";
+		return false;
+	}
+	double c[3];
+	for (int i = 0; i < 3; i++) {
+		c[i] = 0;
+		for (int k = 0; k < 3; k++) {
+			for (int j = 0; j < 3; j++) c[i] -= v[i][k] * v[j][k] / w[k] * g[j];
+		}
+	}
+	double k = 1;
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) k += c[i] * q[i][j] * c[j];
+	}
+	if (k <= 0) {
+		err = "samples don't lie on an ellipsoid";
+		return false;
+	}
+
+	// Back to raw units: bias = mean + scale * c, M = Q / (k * scale^2)
+	// cal = radius * sqrt(M) = V diag(radius * sqrt(w / k) / scale) V'
+	double d[3];
+	for (int i = 0; i < 3; i++) {
+		fit.bias[i] = mean[i] + scale * c[i];
+		d[i] = sqrt(w[i] / k) / scale;
+		fit.radii[i] = 1.0 / d[i];
+	}
+	for (int i = 0; i < 3; i++) {
+		for (int j = 0; j < 3; j++) {
+			double s = 0;
+			for (int m = 0; m < 3; m++) s += v[i][m] * d[m] * v[j][m];
+			fit.cal[i * 3 + j] = radius * s;
+		}
+	}
+	for (int i = 0; i < 2; i++) {
+		for (int j = i + 1; j < 3; j++) {
+			if (fit.radii[j] > fit.radii[i]) {
+				double t = fit.radii[i];
+				fit.radii[i] = fit.radii[j];
+				fit.radii[j] = t;
+			}
+		}
+	}
+
+	// Pass 3: residual on the sphere
+	std::vector<double> sq(threads, 0.0);
+	parallel_blocks(n, threads, [&](size_t begin, size_t end, unsigned b) {
+		double acc = 0;
+		for (size_t i = begin; i < end; i++) {
+			double r[3] = { x[i] - fit.bias[0], y[i] - fit.bias[1], z[i] - fit.bias[2] };
+			double o[3];
+			for (int a = 0; a < 3; a++) o[a] = fit.cal[a * 3] * r[0] + fit.cal[a * 3 + 1] * r[1] + fit.cal[a * 3 + 2] * r[2];
+			double e = sqrt(o[0] * o[0] + o[1] * o[1] + o[2] * o[2]) / radius - 1.0;
+			acc += e * e;
+		}
+		sq[b] = acc;
+	});
+	double total = 0;
+	for (double s : sq) total += s;
+	fit.rms = sqrt(total / n);
+	return true;
+}
@@ -0,0 +1,43 @@
+/*
+
+Least squares ellipsoid fit for magnetometer and accelerometer calibration.
+
+Raw samples of a sensor turned through all orientations lie on an
+ellipsoid: offset by the bias (hard iron / zero-g offset) and stretched by
+scale errors, cross-axis coupling and soft iron. The fit finds bias and the
+symmetric matrix cal with
+
+  |cal * (raw - bias)| = radius
+
+for all samples, which is the correction the UM7 applies with its
+CREG_*_CAL and CREG_*_BIAS registers.
+
+The general quadric
+  A x^2 + B y^2 + C z^2 + 2D xy + 2E xz + 2F yz + 2G x + 2H y + 2I z = 1
+is fit with linear least squares. The 9x9 normal equations are summed over
+the samples by several threads, each over its own block of the arrays, and
+solved with a Cholesky decomposition in double precision.
+
+*/
+
+#ifndef UM7_ELLIPSOID_H
+#define UM7_ELLIPSOID_H
+
+#include <cstddef>
+#include <string>
+
+struct um7_ellipsoid_fit_t {
+	double bias[3];
+	double cal[9];   // row major
+	double radii[3]; // semi-axes of the fitted ellipsoid in raw units, largest first
+	double rms;      // RMS of (|cal * (raw - bias)| - radius) / radius over the samples
+	size_t samples;
+};
+
+// Fits the samples (x[i], y[i], z[i]). threads = 0 uses all cores.
+// Returns false and sets "err" if the samples don't determine an ellipsoid, e.g. when
+// the sensor wasn't turned through enough orientations.
+bool um7_fit_ellipsoid(const float* x, const float* y, const float* z, size_t n, double radius, unsigned threads,
+	um7_ellipsoid_fit_t& fit, std::string& err);
+
+#endif
@@ -0,0 +1,236 @@
+/*
+
+Runs the gait detector (UM7Gait.h, the same code as on the Teensy) over
+logged csv sessions and reports the detected events, the detector's
+throughput and its latency.
+
+The detector gets the newest FSR pair of each record (um7_log_csv.h) and
+the record's gyro, the same inputs logRecord() gives it on the device.
+With DECIMATION_STAGES set the device also sees the samples between the
+logged records, the bench can't.
+
+Latency has two parts: the time update() takes (timed per call here, on
+the host) and the publish delay, how long after the sample an event
+belongs to it is reported (0 for FSR events, one sample for MID_SWING).
+
+Sessions are spread over the worker threads for the throughput figure
+(NS PER UPDATE, with all workers running). The per call times (MAX UPDATE
+NS) are taken afterwards on the main thread alone, one session at a time,
+so the other workers don't add their scheduling noise to the maximum.
+
+Build:
+  g++ -O2 -std=c++17 -pthread -I../.. um7_gait_bench.cpp um7_log_csv.cpp -o um7_gait_bench
+
+Usage:
+  ./um7_gait_bench [options] session1.csv session2.csv ... > results.csv
+
+Options:
+  --shank-imu N                 UM7 on the shank, 1-3 (default 2)
+  --axis x|y|z                  Sagittal gyro axis (default x)
+  --negate                      Negate the gyro, if swing reads negative
+  --heel-on C, --heel-off C     FSR thresholds in counts (defaults from UM7_GAIT_DEFAULT_PARAMS)
+  --toe-on C, --toe-off C
+  --swing-dps D                 Smallest mid-swing peak
+  --min-swing-ms M, --min-stance-ms M
+  --repeat N                    Passes over each session for the throughput figure (default 20)
+  --threads N                   Worker threads (default all cores)
+  --events-dir DIR              Also write the events of each session as csv
+
+Output columns:
+  FILE,SAMPLES,HEEL STRIKE,HEEL OFF,TOE OFF,MID SWING,CADENCE,NS PER UPDATE,MAX UPDATE NS,MAX PUBLISH DELAY US
+
+*/
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UM7Gait.h"
+#include "um7_log_csv.h"
+
+struct options_t {
+	um7_gait_params_t params = UM7_GAIT_DEFAULT_PARAMS;
+	int shank_imu = 2;
+	char axis = 'x';
+	bool negate = false;
+	int repeat = 20;
+	unsigned threads = 0;
+	std::string events_dir;
+	std::vector<std::string> files;
+};
+
+// Detector inputs of a session, kept for the serial latency pass
+struct gait_input_t {
+	std::vector<uint16_t> heel, toe;
+	std::vector<float> dps;
+	std::vector<uint32_t> t;
+};
+
+struct session_result_t {
+	std::string err;
+	gait_input_t in;
+	size_t samples;
+	uint32_t counts[UM7_GAIT_EVENTS];
+	double cadence; // heel strikes per minute
+	double ns_per_update;
+	double max_update_ns;
+	uint64_t max_delay_us;
+};
+
+static const char* EVENT_NAMES[UM7_GAIT_EVENTS] = { "HEEL STRIKE", "HEEL OFF", "TOE OFF", "MID SWING" };
+
+static session_result_t process(const std::string& path, const options_t& opt) {
+	typedef std::chrono::steady_clock clock;
+	session_result_t r;
+	memset(r.counts, 0, sizeof(r.counts));
+	r.samples = 0;
+	r.cadence = r.ns_per_update = r.max_update_ns = 0;
+	r.max_delay_us = 0;
+
+	um7_session_t s;
+	if (!um7_load_csv(path, s, r.err)) return r;
+	if ((int)s.imu.size() < opt.shank_imu || s.size() < 2) {
+		r.err = path + ": no shank imu data";
+		return r;
+	}
+	const um7_imu_series_t& shank = s.imu[opt.shank_imu - 1];
+	const std::vector<float>& g = opt.axis == 'y' ? shank.gy : opt.axis == 'z' ? shank.gz : shank.gx;
+	size_t n = s.size();
+	r.samples = n;
+	std::vector<uint16_t>& heel = r.in.heel;
+	std::vector<uint16_t>& toe = r.in.toe;
+	std::vector<float>& dps = r.in.dps;
+	std::vector<uint32_t>& t = r.in.t;
+	heel.resize(n);
+	toe.resize(n);
+	dps.resize(n);
+	t.resize(n);
+	for (size_t i = 0; i < n; i++) {
+		heel[i] = (uint16_t)s.fsr_heel[i];
+		toe[i] = (uint16_t)s.fsr_toe[i];
+		dps[i] = opt.negate ? -g[i] : g[i];
+		t[i] = (uint32_t)s.t_us[i];
+	}
+
+	// Throughput, whole passes without timing each call
+	UM7Gait gait(opt.params);
+	uint32_t events = 0;
+	clock::time_point start = clock::now();
+	for (int rep = 0; rep < opt.repeat; rep++) {
+		gait.reset();
+		for (size_t i = 0; i < n; i++) events += gait.update(t[i], heel[i], toe[i], dps[i]);
+	}
+	double total_ns = std::chrono::duration<double, std::nano>(clock::now() - start).count();
+	r.ns_per_update = total_ns / ((double)n * (opt.repeat > 0 ? opt.repeat : 1));
+	// Keeps the passes from being optimized away
+	volatile uint32_t sink = events;
+	(void)sink;
+
+	// Events and publish delay
+	FILE* out = nullptr;
+	if (!opt.events_dir.empty()) {
+		std::string base = path.substr(path.find_last_of('/') + 1);
+		std::string name = opt.events_dir + "/" + base.substr(0, base.find_last_of('.')) + "_gait.csv";
+		out = fopen(name.c_str(), "w");
+		if (out) fprintf(out, "TIME,EVENT,PUBLISHED\n");
+	}
+	gait.reset();
+	for (size_t i = 0; i < n; i++) {
+		uint8_t ev = gait.update(t[i], heel[i], toe[i], dps[i]);
+		for (int e = 0; e < UM7_GAIT_EVENTS; e++) {
+			if (!(ev & (1 << e))) continue;
+			uint32_t delay = t[i] - gait.event_t[e];
+			if (delay > r.max_delay_us) r.max_delay_us = delay;
+			if (out) fprintf(out, "%u,%s,%u\n", gait.event_t[e], EVENT_NAMES[e], t[i]);
+		}
+	}
+	if (out) fclose(out);
+	for (int e = 0; e < UM7_GAIT_EVENTS; e++) r.counts[e] = gait.event_count[e];
+	double minutes = (s.t_us[n - 1] - s.t_us[0]) / 60e6;
+	if (minutes > 0) r.cadence = r.counts[0] / minutes;
+	return r;
+}
+
+// Times every update() of a session, run on one thread with no workers left
+static void time_updates(session_result_t& r, const options_t& opt) {
+	typedef std::chrono::steady_clock clock;
+	const gait_input_t& in = r.in;
+	UM7Gait gait(opt.params);
+	uint32_t events = 0;
+	for (size_t i = 0; i < in.t.size(); i++) {
+		clock::time_point a = clock::now();
+		events += gait.update(in.t[i], in.heel[i], in.toe[i], in.dps[i]);
+		double ns = std::chrono::duration<double, std::nano>(clock::now() - a).count();
+		if (ns > r.max_update_ns) r.max_update_ns = ns;
+	}
+	volatile uint32_t sink = events;
+	(void)sink;
+	r.in = gait_input_t();
+}
+
+int main(int argc, char** argv) {
+	options_t opt;
+	for (int i = 1; i < argc; i++) {
+		std::string a = argv[i];
+		bool has_val = i + 1 < argc;
+		if (a == "--shank-imu" && has_val) opt.shank_imu = atoi(argv[++i]);
+		else if (a == "--axis" && has_val) opt.axis = argv[++i][0];
+		else if (a == "--negate") opt.negate = true;
+		else if (a == "--heel-on" && has_val) opt.params.heel_on = atoi(argv[++i]);
+		else if (a == "--heel-off" && has_val) opt.params.heel_off = atoi(argv[++i]);
+		else if (a == "--toe-on" && has_val) opt.params.toe_on = atoi(argv[++i]);
+		else if (a == "--toe-off" && has_val) opt.params.toe_off = atoi(argv[++i]);
+		else if (a == "--swing-dps" && has_val) opt.params.swing_dps = strtof(argv[++i], nullptr);
+		else if (a == "--min-swing-ms" && has_val) opt.params.min_swing_us = atoi(argv[++i]) * 1000;
+		else if (a == "--min-stance-ms" && has_val) opt.params.min_stance_us = atoi(argv[++i]) * 1000;
+		else if (a == "--repeat" && has_val) opt.repeat = atoi(argv[++i]);
+		else if (a == "--threads" && has_val) opt.threads = atoi(argv[++i]);
+		else if (a == "--events-dir" && has_val) opt.events_dir = argv[++i];
+		else if (a.compare(0, 2, "--") == 0) {
+			fprintf(stderr, "unknown option %s\n", a.c_str());
+			return 1;
+		} else opt.files.push_back(a);
+	}
+	if (opt.files.empty()) {
+		fprintf(stderr, "usage: %s [options] session.csv ...\n", argv[0]);
+		return 1;
+	}
+	if (opt.threads == 0) opt.threads = std::thread::hardware_concurrency();
+	if (opt.threads == 0) opt.threads = 1;
+
+	// Sessions are independent, hand them out to workers one at a time
+	std::vector<session_result_t> results(opt.files.size());
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (unsigned w = 0; w < opt.threads && w < opt.files.size(); w++) {
+		workers.emplace_back([&]() {
+			for (size_t i = next++; i < opt.files.size(); i = next++) {
+				results[i] = process(opt.files[i], opt);
+			}
+		});
+	}
+	for (std::thread& t : workers) t.join();
+	for (session_result_t& r : results) {
+		if (r.err.empty()) time_updates(r, opt);
+	}
+
+	printf("FILE,SAMPLES,HEEL STRIKE,HEEL OFF,TOE OFF,MID SWING,CADENCE,NS PER UPDATE,MAX UPDATE NS,MAX PUBLISH DELAY US\n");
+	int status = 0;
+	for (size_t i = 0; i < results.size(); i++) {
+		const session_result_t& r = results[i];
+		if (!r.err.empty()) {
+			fprintf(stderr, "%s\n", r.err.c_str());
+			status = 1;
+			continue;
+		}
+		printf("%s,%zu,%u,%u,%u,%u,%.1f,%.2f,%.0f,%llu\n", opt.files[i].c_str(), r.samples,
+			r.counts[0], r.counts[1], r.counts[2], r.counts[3], r.cadence,
+			r.ns_per_update, r.max_update_ns, (unsigned long long)r.max_delay_us);
+	}
+	return status;
+}
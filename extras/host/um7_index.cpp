@@ -0,0 +1,152 @@
+/*
+
+Random access into SD logger .bin sessions by time.
+
+Builds the sparse time index of each session (um7_bin_index.h, saved as
+"<name>.bin.idx") and extracts time windows from many sessions in
+parallel, reading only the part of each file the window covers.
+
+Build:
+  g++ -O2 -std=c++17 -pthread -I../.. um7_index.cpp um7_bin_index.cpp -o um7_index
+
+Usage:
+  ./um7_index build   [options] session1.bin session2.bin ...
+  ./um7_index info    [options] session1.bin ...
+  ./um7_index extract --from S --to S [options] session1.bin ...
+
+Options:
+  --record-size N     sizeof(data_t) of the logger (default UM7_LOG_DEDICATED_RECORD_SIZE, 116 for
+                      Teensy_DEDICATED_SPI_UM7; 40 for Individual_Teensys, see UM7LogFormat.h)
+  --every N           Records between index entries (default 1000)
+  --max-gap US        Deltas at or above this are missed packet gaps (default 3000, MAX_INTERVAL_USEC)
+  --from S, --to S    Window in seconds since the first record of each session
+  --out-dir DIR       Where extract writes its files (default .)
+  --threads N         Worker threads (default all cores)
+
+build (re)writes the index of every session. info prints one csv line per
+session, building the index first if needed. extract writes
+"<name>_<from>-<to>s.bin" for every session: a dummy sector followed by the
+records of the window, so it reads like a logger .bin.
+
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "um7_bin_index.h"
+
+struct options_t {
+	std::string command;
+	uint32_t record_size = UM7_LOG_DEDICATED_RECORD_SIZE;
+	uint32_t every = 1000;
+	uint32_t max_gap_us = 3000;
+	double from_s = 0.0, to_s = -1.0;
+	std::string out_dir = ".";
+	unsigned threads = 0;
+	std::vector<std::string> files;
+};
+
+struct session_result_t {
+	std::string err;
+	um7_bin_index_t idx;
+	uint64_t window_records;
+};
+
+static session_result_t process(const std::string& path, const options_t& opt) {
+	session_result_t r;
+	r.window_records = 0;
+	if (opt.command == "build") {
+		if (um7_index_build(path, opt.record_size, opt.every, opt.max_gap_us, r.idx, r.err)) {
+			um7_index_save(path + ".idx", r.idx, r.err);
+		}
+		return r;
+	}
+	if (!um7_index_open(path, opt.record_size, opt.every, opt.max_gap_us, r.idx, r.err)) return r;
+	if (opt.command != "extract") return r;
+
+	std::vector<uint8_t> records;
+	uint64_t first;
+	uint64_t from_us = (uint64_t)(opt.from_s * 1e6);
+	uint64_t to_us = opt.to_s < 0 ? UINT64_MAX : (uint64_t)(opt.to_s * 1e6);
+	if (!um7_index_read_window(path, r.idx, from_us, to_us, records, first, r.err)) return r;
+	r.window_records = records.size() / opt.record_size;
+
+	std::string base = path.substr(path.find_last_of('/') + 1);
+	char window[64];
+	snprintf(window, sizeof(window), "_%g-%gs.bin", opt.from_s, opt.to_s < 0 ? r.idx.duration_us / 1e6 : opt.to_s);
+	std::string name = opt.out_dir + "/" + base.substr(0, base.find_last_of('.')) + window;
+	FILE* out = fopen(name.c_str(), "wb");
+	if (!out) {
+		r.err = name + ": cannot create";
+		return r;
+	}
+	std::vector<uint8_t> dummy(UM7_INDEX_DATA_OFFSET, 0);
+	bool ok = fwrite(dummy.data(), 1, dummy.size(), out) == dummy.size()
+		&& fwrite(records.data(), 1, records.size(), out) == records.size();
+	if (fclose(out) != 0 || !ok) r.err = name + ": write failed";
+	return r;
+}
+
+int main(int argc, char** argv) {
+	options_t opt;
+	if (argc > 1) opt.command = argv[1];
+	for (int i = 2; i < argc; i++) {
+		std::string a = argv[i];
+		bool has_val = i + 1 < argc;
+		if (a == "--record-size" && has_val) opt.record_size = atoi(argv[++i]);
+		else if (a == "--every" && has_val) opt.every = atoi(argv[++i]);
+		else if (a == "--max-gap" && has_val) opt.max_gap_us = atoi(argv[++i]);
+		else if (a == "--from" && has_val) opt.from_s = strtod(argv[++i], nullptr);
+		else if (a == "--to" && has_val) opt.to_s = strtod(argv[++i], nullptr);
+		else if (a == "--out-dir" && has_val) opt.out_dir = argv[++i];
+		else if (a == "--threads" && has_val) opt.threads = atoi(argv[++i]);
+		else if (a.compare(0, 2, "--") == 0) {
+			fprintf(stderr, "unknown option %s\n", a.c_str());
+			return 1;
+		} else opt.files.push_back(a);
+	}
+	if ((opt.command != "build" && opt.command != "info" && opt.command != "extract") || opt.files.empty()) {
+		fprintf(stderr, "usage: %s build|info|extract [options] session.bin ...\n", argv[0]);
+		return 1;
+	}
+	if (opt.threads == 0) opt.threads = std::thread::hardware_concurrency();
+	if (opt.threads == 0) opt.threads = 1;
+
+	// Sessions are independent, hand them out to workers one at a time
+	std::vector<session_result_t> results(opt.files.size());
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (unsigned w = 0; w < opt.threads && w < opt.files.size(); w++) {
+		workers.emplace_back([&]() {
+			for (size_t i = next++; i < opt.files.size(); i = next++) {
+				results[i] = process(opt.files[i], opt);
+			}
+		});
+	}
+	for (std::thread& t : workers) t.join();
+
+	printf("FILE,RECORDS,DURATION,ENTRIES,GAPS,LONGEST GAP%s\n", opt.command == "extract" ? ",WINDOW RECORDS" : "");
+	int status = 0;
+	for (size_t i = 0; i < results.size(); i++) {
+		if (!results[i].err.empty()) {
+			fprintf(stderr, "%s\n", results[i].err.c_str());
+			status = 1;
+			continue;
+		}
+		const um7_bin_index_t& idx = results[i].idx;
+		uint64_t longest = 0;
+		for (const um7_index_gap_t& g : idx.gaps) {
+			if (g.t_after_us - g.t_before_us > longest) longest = g.t_after_us - g.t_before_us;
+		}
+		printf("%s,%llu,%.6f,%zu,%zu,%llu", opt.files[i].c_str(), (unsigned long long)idx.records,
+			idx.duration_us / 1e6, idx.entries.size(), idx.gaps.size(), (unsigned long long)longest);
+		if (opt.command == "extract") printf(",%llu", (unsigned long long)results[i].window_records);
+		printf("\n");
+	}
+	return status;
+}
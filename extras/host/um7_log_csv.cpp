@@ -0,0 +1,131 @@
+/*
+
+Loader for the csv files written by the SD logger examples.
+See um7_log_csv.h.
+
+*/
+
+#include "um7_log_csv.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+// Splits a line in place on commas
+static void split_line(char* line, std::vector<char*>& fields) {
+	fields.clear();
+	fields.push_back(line);
+	for (char* p = line; *p; p++) {
+		if (*p == ',') {
+			*p = 0;
+			fields.push_back(p + 1);
+		}
+	}
+}
+
+static int find_column(const std::vector<std::string>& header, const std::string& name) {
+	for (size_t i = 0; i < header.size(); i++) {
+		if (header[i] == name) return (int)i;
+	}
+	return -1;
+}
+
+bool um7_load_csv(const std::string& path, um7_session_t& s, std::string& err) {
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) {
+		err = path + ": cannot open";
+		return false;
+	}
+	fseek(f, 0, SEEK_END);
+	long size = ftell(f);
+	fseek(f, 0, SEEK_SET);
+	std::vector<char> text(size + 1);
+	if (size > 0 && fread(text.data(), 1, size, f) != (size_t)size) {
+		fclose(f);
+		err = path + ": read failed";
+		return false;
+	}
+	fclose(f);
+	text[size] = 0;
+
+	s = um7_session_t();
+	s.path = path;
+	s.interval_us = 0;
+
+	std::vector<std::string> header;
+	std::vector<char*> fields;
+	int c_time = -1, c_heel = -1, c_toe = -1;
+	// Per imu: gx gy gz ax ay az roll pitch yaw
+	std::vector<int> c_imu;
+	uint64_t t_hi = 0;
+	uint32_t t_last = 0;
+
+	char* line = text.data();
+	while (line && *line) {
+		char* next = strchr(line, '\n');
+		if (next) *next++ = 0;
+		size_t len = strlen(line);
+		if (len && line[len - 1] == '\r') line[len - 1] = 0;
+
+		if (header.empty()) {
+			if (strncmp(line, "LOG INTERVAL,", 13) == 0) {
+				s.interval_us = strtoul(line + 13, nullptr, 10);
+			} else if (strncmp(line, "TRANSFER #", 10) == 0) {
+				split_line(line, fields);
+				for (char* h : fields) header.push_back(h);
+				c_time = find_column(header, "TIME");
+				c_heel = find_column(header, "FSR HEEL");
+				c_toe = find_column(header, "FSR TOE");
+				// Pairs 2..N follow as "FSR HEEL 2", keep the last one
+				for (int n = 2;; n++) {
+					std::string k = std::to_string(n);
+					int h = find_column(header, "FSR HEEL " + k), t = find_column(header, "FSR TOE " + k);
+					if (h < 0 || t < 0) break;
+					c_heel = h;
+					c_toe = t;
+				}
+				static const char* names[9] = { "G%dX", "G%dY", "G%dZ", "A%dX", "A%dY", "A%dZ", "ROLL%d", "PITCH%d", "YAW%d" };
+				for (int n = 1;; n++) {
+					char name[16];
+					snprintf(name, sizeof(name), names[0], n);
+					if (find_column(header, name) < 0) break;
+					for (int k = 0; k < 9; k++) {
+						snprintf(name, sizeof(name), names[k], n);
+						c_imu.push_back(find_column(header, name));
+					}
+				}
+				if (c_time < 0) {
+					err = path + ": no TIME column";
+					return false;
+				}
+				s.imu.resize(c_imu.size() / 9);
+			}
+		} else if (*line >= '0' && *line <= '9') {
+			split_line(line, fields);
+			if (fields.size() < header.size()) {
+				line = next;
+				continue;
+			}
+			uint32_t t = strtoul(fields[c_time], nullptr, 10);
+			if (!s.t_us.empty() && t < t_last) t_hi += 1ULL << 32;
+			t_last = t;
+			s.t_us.push_back(t_hi | t);
+			s.fsr_heel.push_back(c_heel >= 0 ? strtof(fields[c_heel], nullptr) : 0);
+			s.fsr_toe.push_back(c_toe >= 0 ? strtof(fields[c_toe], nullptr) : 0);
+			for (size_t i = 0; i < s.imu.size(); i++) {
+				const int* c = &c_imu[i * 9];
+				um7_imu_series_t& m = s.imu[i];
+				std::vector<float>* cols[9] = { &m.gx, &m.gy, &m.gz, &m.ax, &m.ay, &m.az, &m.roll, &m.pitch, &m.yaw };
+				for (int k = 0; k < 9; k++) {
+					cols[k]->push_back(c[k] >= 0 ? strtof(fields[c[k]], nullptr) : 0);
+				}
+			}
+		}
+		line = next;
+	}
+	if (header.empty()) {
+		err = path + ": no header line";
+		return false;
+	}
+	return true;
+}
@@ -0,0 +1,45 @@
+/*
+
+Loader for the csv files written by the SD logger examples (binaryToCsv()).
+
+Columns are found by their header names (TIME, FSR HEEL, G1X ... YAW3), so
+the loader keeps working when a logger adds or reorders columns. The info
+lines above the header and the "Missed Packet(s)" lines are skipped.
+
+Records with several FSR pairs (FSR HEEL, FSR HEEL 2 ... FSR HEEL N) load
+only the last, newest pair: the one Teensy_DEDICATED_SPI_UM7 feeds the gait
+detector with.
+
+The 32 bit microsecond TIME column wraps after ~71 minutes, t_us is
+unwrapped to 64 bits.
+
+*/
+
+#ifndef UM7_LOG_CSV_H
+#define UM7_LOG_CSV_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One sensor's channels over a session
+struct um7_imu_series_t {
+	std::vector<float> gx, gy, gz; // deg/s
+	std::vector<float> ax, ay, az; // G
+	std::vector<float> roll, pitch, yaw; // deg, UM7 onboard EKF
+};
+
+struct um7_session_t {
+	std::string path;
+	uint32_t interval_us; // LOG INTERVAL line, 0 if missing
+	std::vector<uint64_t> t_us;
+	std::vector<float> fsr_heel, fsr_toe; // newest FSR pair of each record
+	std::vector<um7_imu_series_t> imu;
+
+	size_t size() const { return t_us.size(); }
+};
+
+// Loads a logger csv into "s". Returns false and sets "err" on failure.
+bool um7_load_csv(const std::string& path, um7_session_t& s, std::string& err);
+
+#endif
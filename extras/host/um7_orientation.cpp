@@ -0,0 +1,151 @@
+/*
+
+Host-side orientation filters. See um7_orientation.h.
+
+*/
+
+#include "um7_orientation.h"
+
+#include <cmath>
+
+static const float DEG_TO_RAD = 0.01745329252f;
+static const float RAD_TO_DEG = 57.2957795131f;
+
+OrientationBank::OrientationBank(um7_filter_t type, const std::vector<int>& lane_imu,
+	const std::vector<um7_filter_params_t>& lane_params)
+	: type_(type), lane_imu_(lane_imu) {
+	size_t n = lane_imu_.size();
+	for (size_t l = 0; l < n; l++) {
+		beta_.push_back(lane_params[l].beta);
+		kp_.push_back(lane_params[l].kp);
+		ki_.push_back(lane_params[l].ki);
+	}
+	q0_.assign(n, 1.0f);
+	q1_.assign(n, 0.0f);
+	q2_.assign(n, 0.0f);
+	q3_.assign(n, 0.0f);
+	ix_.assign(n, 0.0f);
+	iy_.assign(n, 0.0f);
+	iz_.assign(n, 0.0f);
+	gx_.resize(n); gy_.resize(n); gz_.resize(n);
+	ax_.resize(n); ay_.resize(n); az_.resize(n);
+}
+
+void OrientationBank::gather(const float* src, std::vector<float>& dst) const {
+	for (size_t l = 0; l < lane_imu_.size(); l++) dst[l] = src[lane_imu_[l]];
+}
+
+void OrientationBank::init(const float* ax, const float* ay, const float* az) {
+	gather(ax, ax_);
+	gather(ay, ay_);
+	gather(az, az_);
+	for (size_t l = 0; l < lanes(); l++) {
+		float roll = atan2f(ay_[l], az_[l]);
+		float pitch = atan2f(-ax_[l], sqrtf(ay_[l] * ay_[l] + az_[l] * az_[l]));
+		float cr = cosf(roll * 0.5f), sr = sinf(roll * 0.5f);
+		float cp = cosf(pitch * 0.5f), sp = sinf(pitch * 0.5f);
+		q0_[l] = cr * cp;
+		q1_[l] = sr * cp;
+		q2_[l] = cr * sp;
+		q3_[l] = -sr * sp;
+		ix_[l] = iy_[l] = iz_[l] = 0.0f;
+	}
+}
+
+// The lane kernels take every array as a __restrict parameter. GCC only vectorizes the loops
+// when it can see the arrays don't alias, which it can't prove for pointers taken from the
+// member vectors inside update(). sqrtf also needs -fno-math-errno, otherwise the errno
+// branch is control flow in the loop. Check with -fopt-info-vec.
+static void madgwick_lanes(size_t n, float dt, float* __restrict q0, float* __restrict q1,
+	float* __restrict q2, float* __restrict q3, const float* __restrict wx, const float* __restrict wy,
+	const float* __restrict wz, const float* __restrict fx, const float* __restrict fy,
+	const float* __restrict fz, const float* __restrict beta) {
+	for (size_t l = 0; l < n; l++) {
+		float g1 = wx[l] * DEG_TO_RAD, g2 = wy[l] * DEG_TO_RAD, g3 = wz[l] * DEG_TO_RAD;
+		float a0 = q0[l], a1 = q1[l], a2 = q2[l], a3 = q3[l];
+
+		// Rate of change from the gyro
+		float d0 = 0.5f * (-a1 * g1 - a2 * g2 - a3 * g3);
+		float d1 = 0.5f * (a0 * g1 + a2 * g3 - a3 * g2);
+		float d2 = 0.5f * (a0 * g2 - a1 * g3 + a3 * g1);
+		float d3 = 0.5f * (a0 * g3 + a1 * g2 - a2 * g1);
+
+		// Gradient descent step towards the measured gravity direction
+		float rn = 1.0f / sqrtf(fx[l] * fx[l] + fy[l] * fy[l] + fz[l] * fz[l] + 1e-12f);
+		float x = fx[l] * rn, y = fy[l] * rn, z = fz[l] * rn;
+		float s0 = 4.0f * a0 * a2 * a2 + 2.0f * a2 * x + 4.0f * a0 * a1 * a1 - 2.0f * a1 * y;
+		float s1 = 4.0f * a1 * a3 * a3 - 2.0f * a3 * x + 4.0f * a0 * a0 * a1 - 2.0f * a0 * y - 4.0f * a1
+			+ 8.0f * a1 * a1 * a1 + 8.0f * a1 * a2 * a2 + 4.0f * a1 * z;
+		float s2 = 4.0f * a0 * a0 * a2 + 2.0f * a0 * x + 4.0f * a2 * a3 * a3 - 2.0f * a3 * y - 4.0f * a2
+			+ 8.0f * a2 * a1 * a1 + 8.0f * a2 * a2 * a2 + 4.0f * a2 * z;
+		float s3 = 4.0f * a1 * a1 * a3 - 2.0f * a1 * x + 4.0f * a2 * a2 * a3 - 2.0f * a2 * y;
+		float sn = beta[l] / sqrtf(s0 * s0 + s1 * s1 + s2 * s2 + s3 * s3 + 1e-12f);
+
+		a0 += (d0 - sn * s0) * dt;
+		a1 += (d1 - sn * s1) * dt;
+		a2 += (d2 - sn * s2) * dt;
+		a3 += (d3 - sn * s3) * dt;
+		float qn = 1.0f / sqrtf(a0 * a0 + a1 * a1 + a2 * a2 + a3 * a3);
+		q0[l] = a0 * qn; q1[l] = a1 * qn; q2[l] = a2 * qn; q3[l] = a3 * qn;
+	}
+}
+
+static void complementary_lanes(size_t n, float dt, float* __restrict q0, float* __restrict q1,
+	float* __restrict q2, float* __restrict q3, float* __restrict ix, float* __restrict iy,
+	float* __restrict iz, const float* __restrict wx, const float* __restrict wy, const float* __restrict wz,
+	const float* __restrict fx, const float* __restrict fy, const float* __restrict fz,
+	const float* __restrict kp, const float* __restrict ki) {
+	for (size_t l = 0; l < n; l++) {
+		float a0 = q0[l], a1 = q1[l], a2 = q2[l], a3 = q3[l];
+
+		// Error between measured and estimated gravity direction
+		float rn = 1.0f / sqrtf(fx[l] * fx[l] + fy[l] * fy[l] + fz[l] * fz[l] + 1e-12f);
+		float x = fx[l] * rn, y = fy[l] * rn, z = fz[l] * rn;
+		float vx = 2.0f * (a1 * a3 - a0 * a2);
+		float vy = 2.0f * (a0 * a1 + a2 * a3);
+		float vz = a0 * a0 - a1 * a1 - a2 * a2 + a3 * a3;
+		float ex = y * vz - z * vy;
+		float ey = z * vx - x * vz;
+		float ez = x * vy - y * vx;
+
+		ix[l] += ki[l] * ex * dt;
+		iy[l] += ki[l] * ey * dt;
+		iz[l] += ki[l] * ez * dt;
+		float g1 = wx[l] * DEG_TO_RAD + kp[l] * ex + ix[l];
+		float g2 = wy[l] * DEG_TO_RAD + kp[l] * ey + iy[l];
+		float g3 = wz[l] * DEG_TO_RAD + kp[l] * ez + iz[l];
+
+		float h = 0.5f * dt;
+		float b0 = a0 + (-a1 * g1 - a2 * g2 - a3 * g3) * h;
+		float b1 = a1 + (a0 * g1 + a2 * g3 - a3 * g2) * h;
+		float b2 = a2 + (a0 * g2 - a1 * g3 + a3 * g1) * h;
+		float b3 = a3 + (a0 * g3 + a1 * g2 - a2 * g1) * h;
+		float qn = 1.0f / sqrtf(b0 * b0 + b1 * b1 + b2 * b2 + b3 * b3);
+		q0[l] = b0 * qn; q1[l] = b1 * qn; q2[l] = b2 * qn; q3[l] = b3 * qn;
+	}
+}
+
+void OrientationBank::update(float dt, const float* gx, const float* gy, const float* gz,
+	const float* ax, const float* ay, const float* az) {
+	gather(gx, gx_); gather(gy, gy_); gather(gz, gz_);
+	gather(ax, ax_); gather(ay, ay_); gather(az, az_);
+
+	if (type_ == UM7_FILTER_MADGWICK) {
+		madgwick_lanes(lanes(), dt, q0_.data(), q1_.data(), q2_.data(), q3_.data(),
+			gx_.data(), gy_.data(), gz_.data(), ax_.data(), ay_.data(), az_.data(), beta_.data());
+	} else {
+		complementary_lanes(lanes(), dt, q0_.data(), q1_.data(), q2_.data(), q3_.data(),
+			ix_.data(), iy_.data(), iz_.data(), gx_.data(), gy_.data(), gz_.data(),
+			ax_.data(), ay_.data(), az_.data(), kp_.data(), ki_.data());
+	}
+}
+
+void OrientationBank::euler(float* roll, float* pitch) const {
+	for (size_t l = 0; l < lanes(); l++) {
+		float a0 = q0_[l], a1 = q1_[l], a2 = q2_[l], a3 = q3_[l];
+		roll[l] = atan2f(2.0f * (a0 * a1 + a2 * a3), 1.0f - 2.0f * (a1 * a1 + a2 * a2)) * RAD_TO_DEG;
+		float sp = 2.0f * (a0 * a2 - a3 * a1);
+		sp = sp > 1.0f ? 1.0f : (sp < -1.0f ? -1.0f : sp);
+		pitch[l] = asinf(sp) * RAD_TO_DEG;
+	}
+}
@@ -0,0 +1,78 @@
+/*
+
+Host-side orientation filters for re-estimating attitude from logged
+gyro/accel data after a trial.
+
+A bank runs many independent filter lanes in lock step over one session.
+Each lane has its own sensor index and parameters, so every sensor of a
+session and every point of a parameter sweep share one pass over the data.
+State is stored as structure-of-arrays and the per-sample update loops over
+lanes without branches. GCC vectorizes both filter loops when built with
+-O3 -march=native -fno-math-errno (without -fno-math-errno the sqrtf errno
+branch blocks it, check with -fopt-info-vec).
+
+Filters:
+ - Madgwick gradient descent (beta)
+ - Complementary / Mahony PI filter on the gravity error (kp, ki)
+
+Both use gyro + accel only, so yaw drifts and only roll/pitch are comparable
+to the UM7's onboard EKF.
+
+*/
+
+#ifndef UM7_ORIENTATION_H
+#define UM7_ORIENTATION_H
+
+#include <cstddef>
+#include <vector>
+
+enum um7_filter_t {
+	UM7_FILTER_MADGWICK,
+	UM7_FILTER_COMPLEMENTARY
+};
+
+struct um7_filter_params_t {
+	float beta;   // Madgwick gain, rad/s
+	float kp, ki; // Complementary proportional and integral gains
+};
+
+class OrientationBank {
+
+public:
+
+	// "lane_imu" maps every lane to the sensor index it reads
+	OrientationBank(um7_filter_t type, const std::vector<int>& lane_imu,
+		const std::vector<um7_filter_params_t>& lane_params);
+
+	size_t lanes() const { return lane_imu_.size(); }
+	int lane_imu(size_t lane) const { return lane_imu_[lane]; }
+
+	// Sets every lane's attitude from its first accel sample, yaw = 0.
+	// ax..az are indexed by sensor.
+	void init(const float* ax, const float* ay, const float* az);
+
+	// Advances every lane by dt seconds. gyro in deg/s, accel in any unit,
+	// all indexed by sensor.
+	void update(float dt, const float* gx, const float* gy, const float* gz,
+		const float* ax, const float* ay, const float* az);
+
+	// Current roll and pitch of every lane in degrees
+	void euler(float* roll, float* pitch) const;
+
+private:
+
+	void gather(const float* src, std::vector<float>& dst) const;
+
+	um7_filter_t type_;
+	std::vector<int> lane_imu_;
+	std::vector<float> beta_, kp_, ki_;
+
+	// Quaternion state and complementary integral terms
+	std::vector<float> q0_, q1_, q2_, q3_;
+	std::vector<float> ix_, iy_, iz_;
+
+	// Per-sample inputs gathered per lane
+	std::vector<float> gx_, gy_, gz_, ax_, ay_, az_;
+};
+
+#endif
@@ -0,0 +1,246 @@
+/*
+
+Batch orientation re-estimation over logged sessions.
+
+Re-runs a Madgwick or complementary filter over the gyro/accel columns of
+logger csv files and scores the roll/pitch against the UM7's onboard EKF
+columns. Every sensor and every point of the parameter sweep of a session is
+one lane of a vectorized OrientationBank, and sessions are spread over all
+cores.
+
+Build:
+  g++ -O3 -march=native -fno-math-errno -std=c++17 -pthread um7_reestimate.cpp um7_orientation.cpp um7_log_csv.cpp -o um7_reestimate
+
+Usage:
+  ./um7_reestimate [options] session1.csv session2.csv ... > results.csv
+
+Options:
+  --filter madgwick|complementary   (default madgwick)
+  --beta LIST                       Madgwick gains (default 0.1)
+  --kp LIST, --ki LIST              Complementary gains (default 1.0, 0.0)
+  --gyro-scale S, --accel-scale S   Multiply inputs, e.g. to convert raw counts (default 1)
+  --flip-accel                      Negate accel if the sensor reads -1 G on z when flat
+  --threads N                       Worker threads (default all cores)
+  --out-dir DIR                     Also write re-estimated roll/pitch per session
+
+LIST is either "a,b,c" or "start:stop:step".
+
+Output columns:
+  FILE,IMU,FILTER,BETA,KP,KI,SAMPLES,RMS ROLL,RMS PITCH,MAX ROLL,MAX PITCH
+
+*/
+
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "um7_log_csv.h"
+#include "um7_orientation.h"
+
+struct options_t {
+	um7_filter_t filter = UM7_FILTER_MADGWICK;
+	std::vector<float> beta{0.1f}, kp{1.0f}, ki{0.0f};
+	float gyro_scale = 1.0f, accel_scale = 1.0f;
+	bool flip_accel = false;
+	unsigned threads = 0;
+	std::string out_dir;
+	std::vector<std::string> files;
+};
+
+struct lane_result_t {
+	int imu;
+	um7_filter_params_t params;
+	size_t samples;
+	double sq_roll, sq_pitch;
+	float max_roll, max_pitch;
+};
+
+struct session_result_t {
+	std::string err;
+	std::vector<lane_result_t> lanes;
+};
+
+static std::vector<float> parse_list(const char* s) {
+	std::vector<float> v;
+	float a, b, step;
+	if (sscanf(s, "%f:%f:%f", &a, &b, &step) == 3 && step > 0) {
+		for (int i = 0; a + i * step <= b + step * 1e-3f; i++) v.push_back(a + i * step);
+		return v;
+	}
+	for (const char* p = s; *p;) {
+		char* end;
+		v.push_back(strtof(p, &end));
+		if (end == p) break;
+		p = *end == ',' ? end + 1 : end;
+	}
+	return v;
+}
+
+static float wrap180(float d) {
+	while (d > 180.0f) d -= 360.0f;
+	while (d < -180.0f) d += 360.0f;
+	return d;
+}
+
+static session_result_t process(const std::string& path, const options_t& opt) {
+	session_result_t r;
+	um7_session_t s;
+	if (!um7_load_csv(path, s, r.err)) return r;
+	if (s.imu.empty() || s.size() < 2) {
+		r.err = path + ": no imu data";
+		return r;
+	}
+	size_t n_imus = s.imu.size();
+
+	// One lane per sensor per parameter combination
+	std::vector<int> lane_imu;
+	std::vector<um7_filter_params_t> params;
+	for (size_t i = 0; i < n_imus; i++) {
+		if (opt.filter == UM7_FILTER_MADGWICK) {
+			for (float b : opt.beta) {
+				lane_imu.push_back(i);
+				params.push_back({b, 0, 0});
+			}
+		} else {
+			for (float p : opt.kp) {
+				for (float k : opt.ki) {
+					lane_imu.push_back(i);
+					params.push_back({0, p, k});
+				}
+			}
+		}
+	}
+	OrientationBank bank(opt.filter, lane_imu, params);
+	size_t n_lanes = bank.lanes();
+
+	r.lanes.resize(n_lanes);
+	for (size_t l = 0; l < n_lanes; l++) {
+		r.lanes[l] = {lane_imu[l], params[l], 0, 0.0, 0.0, 0.0f, 0.0f};
+	}
+
+	FILE* out = nullptr;
+	if (!opt.out_dir.empty()) {
+		std::string base = path.substr(path.find_last_of('/') + 1);
+		std::string name = opt.out_dir + "/" + base.substr(0, base.find_last_of('.')) + "_reestimated.csv";
+		out = fopen(name.c_str(), "w");
+		if (out) {
+			fprintf(out, "TIME");
+			for (size_t l = 0; l < n_lanes; l++) {
+				fprintf(out, ",ROLL%d_%zu,PITCH%d_%zu", lane_imu[l] + 1, l, lane_imu[l] + 1, l);
+			}
+			fprintf(out, "\n");
+		}
+	}
+
+	std::vector<float> gx(n_imus), gy(n_imus), gz(n_imus), ax(n_imus), ay(n_imus), az(n_imus);
+	std::vector<float> roll(n_lanes), pitch(n_lanes);
+	float fa = opt.flip_accel ? -1.0f : 1.0f;
+
+	for (size_t k = 0; k < s.size(); k++) {
+		for (size_t i = 0; i < n_imus; i++) {
+			const um7_imu_series_t& m = s.imu[i];
+			gx[i] = m.gx[k] * opt.gyro_scale;
+			gy[i] = m.gy[k] * opt.gyro_scale;
+			gz[i] = m.gz[k] * opt.gyro_scale;
+			ax[i] = m.ax[k] * opt.accel_scale * fa;
+			ay[i] = m.ay[k] * opt.accel_scale * fa;
+			az[i] = m.az[k] * opt.accel_scale * fa;
+		}
+		if (k == 0) {
+			bank.init(ax.data(), ay.data(), az.data());
+		} else {
+			float dt = (s.t_us[k] - s.t_us[k - 1]) * 1e-6f;
+			bank.update(dt, gx.data(), gy.data(), gz.data(), ax.data(), ay.data(), az.data());
+		}
+		bank.euler(roll.data(), pitch.data());
+
+		for (size_t l = 0; l < n_lanes; l++) {
+			lane_result_t& lr = r.lanes[l];
+			const um7_imu_series_t& m = s.imu[lr.imu];
+			float er = fabsf(wrap180(roll[l] - m.roll[k]));
+			float ep = fabsf(pitch[l] - m.pitch[k]);
+			lr.sq_roll += er * er;
+			lr.sq_pitch += ep * ep;
+			if (er > lr.max_roll) lr.max_roll = er;
+			if (ep > lr.max_pitch) lr.max_pitch = ep;
+			lr.samples++;
+		}
+		if (out) {
+			fprintf(out, "%llu", (unsigned long long)s.t_us[k]);
+			for (size_t l = 0; l < n_lanes; l++) fprintf(out, ",%.3f,%.3f", roll[l], pitch[l]);
+			fprintf(out, "\n");
+		}
+	}
+	if (out) fclose(out);
+	return r;
+}
+
+int main(int argc, char** argv) {
+	options_t opt;
+	for (int i = 1; i < argc; i++) {
+		std::string a = argv[i];
+		bool has_val = i + 1 < argc;
+		if (a == "--filter" && has_val) {
+			std::string f = argv[++i];
+			if (f == "madgwick") opt.filter = UM7_FILTER_MADGWICK;
+			else if (f == "complementary") opt.filter = UM7_FILTER_COMPLEMENTARY;
+			else {
+				fprintf(stderr, "unknown filter %s\n", f.c_str());
+				return 1;
+			}
+		} else if (a == "--beta" && has_val) opt.beta = parse_list(argv[++i]);
+		else if (a == "--kp" && has_val) opt.kp = parse_list(argv[++i]);
+		else if (a == "--ki" && has_val) opt.ki = parse_list(argv[++i]);
+		else if (a == "--gyro-scale" && has_val) opt.gyro_scale = strtof(argv[++i], nullptr);
+		else if (a == "--accel-scale" && has_val) opt.accel_scale = strtof(argv[++i], nullptr);
+		else if (a == "--flip-accel") opt.flip_accel = true;
+		else if (a == "--threads" && has_val) opt.threads = atoi(argv[++i]);
+		else if (a == "--out-dir" && has_val) opt.out_dir = argv[++i];
+		else if (a.compare(0, 2, "--") == 0) {
+			fprintf(stderr, "unknown option %s\n", a.c_str());
+			return 1;
+		} else opt.files.push_back(a);
+	}
+	if (opt.files.empty()) {
+		fprintf(stderr, "usage: %s [options] session.csv ...\n", argv[0]);
+		return 1;
+	}
+	if (opt.threads == 0) opt.threads = std::thread::hardware_concurrency();
+	if (opt.threads == 0) opt.threads = 1;
+
+	// Sessions are independent, hand them out to workers one at a time
+	std::vector<session_result_t> results(opt.files.size());
+	std::atomic<size_t> next(0);
+	std::vector<std::thread> workers;
+	for (unsigned w = 0; w < opt.threads && w < opt.files.size(); w++) {
+		workers.emplace_back([&]() {
+			for (size_t i = next++; i < opt.files.size(); i = next++) {
+				results[i] = process(opt.files[i], opt);
+			}
+		});
+	}
+	for (std::thread& t : workers) t.join();
+
+	const char* fname = opt.filter == UM7_FILTER_MADGWICK ? "madgwick" : "complementary";
+	printf("FILE,IMU,FILTER,BETA,KP,KI,SAMPLES,RMS ROLL,RMS PITCH,MAX ROLL,MAX PITCH\n");
+	int status = 0;
+	for (size_t i = 0; i < results.size(); i++) {
+		if (!results[i].err.empty()) {
+			fprintf(stderr, "%s\n", results[i].err.c_str());
+			status = 1;
+			continue;
+		}
+		for (const lane_result_t& l : results[i].lanes) {
+			double n = l.samples ? (double)l.samples : 1.0;
+			printf("%s,%d,%s,%g,%g,%g,%zu,%.4f,%.4f,%.3f,%.3f\n", opt.files[i].c_str(), l.imu + 1, fname,
+				l.params.beta, l.params.kp, l.params.ki, l.samples,
+				sqrt(l.sq_roll / n), sqrt(l.sq_pitch / n), l.max_roll, l.max_pitch);
+		}
+	}
+	return status;
+}
@@ -0,0 +1,171 @@
+/*
+
+Stress test for UM7Seqlock.h, the same header the library shares its
+samples through.
+
+One writer thread publishes payloads whose every word is derived from the
+write number, N reader threads read as fast as they can and check each copy:
+all words must belong to the same write, that write must be the one read()
+returned, and the numbers a reader sees must never go backwards. Any
+mismatch is a torn read.
+
+Two payloads are run, one of whole words and one of an odd number of bytes,
+which the seqlock copies with a partial last word.
+
+Build with ThreadSanitizer, which also checks the seqlock's memory ordering:
+  g++ -O2 -g -std=c++17 -pthread -fsanitize=thread -I../.. um7_seqlock_stress.cpp -o um7_seqlock_stress
+
+Without -fsanitize=thread the same run takes well under a second, raise
+--writes there to look harder for torn reads.
+
+Usage:
+  ./um7_seqlock_stress [options]
+
+Options:
+  --readers N                   Reader threads (default all cores - 1, at least 2)
+  --writes N                    Writes per payload (default 2000000)
+
+Prints one line per payload and exits with 1 if any check failed.
+
+*/
+
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "UM7Seqlock.h"
+
+struct options_t {
+	unsigned readers = 0;
+	uint32_t writes = 2000000;
+};
+
+// 64 Bytes, whole words
+struct word_payload_t {
+	uint32_t n;
+	uint32_t v[15];
+};
+
+// 37 Bytes, the last word is partial
+struct byte_payload_t {
+	uint8_t n[4];
+	uint8_t v[33];
+};
+
+static uint32_t mix(uint32_t n, uint32_t i) {
+	uint32_t x = n * 0x9E3779B1u + i * 0x85EBCA77u;
+	x ^= x >> 15;
+	x *= 0x2C1B3C6Du;
+	return x ^ (x >> 12);
+}
+
+static void fill(word_payload_t& p, uint32_t n) {
+	p.n = n;
+	for (int i = 0; i < 15; i++) p.v[i] = mix(n, i);
+}
+
+static uint32_t payload_n(const word_payload_t& p) {
+	return p.n;
+}
+
+static bool consistent(const word_payload_t& p) {
+	for (int i = 0; i < 15; i++) {
+		if (p.v[i] != mix(p.n, i)) return false;
+	}
+	return true;
+}
+
+static void fill(byte_payload_t& p, uint32_t n) {
+	for (int i = 0; i < 4; i++) p.n[i] = (uint8_t)(n >> (8 * i));
+	for (int i = 0; i < 33; i++) p.v[i] = (uint8_t)mix(n, i);
+}
+
+static uint32_t payload_n(const byte_payload_t& p) {
+	return p.n[0] | (p.n[1] << 8) | (p.n[2] << 16) | ((uint32_t)p.n[3] << 24);
+}
+
+static bool consistent(const byte_payload_t& p) {
+	uint32_t n = payload_n(p);
+	for (int i = 0; i < 33; i++) {
+		if (p.v[i] != (uint8_t)mix(n, i)) return false;
+	}
+	return true;
+}
+
+struct reader_result_t {
+	uint64_t reads = 0;
+	uint64_t torn = 0; // words from different writes
+	uint64_t mismatched = 0; // consistent, but not the write read() returned
+	uint64_t backwards = 0; // older than the previous read
+};
+
+template <typename T>
+static bool run(const char* name, const options_t& opt) {
+	static UM7Seqlock<T> lock;
+	std::atomic<bool> done(false);
+	std::vector<reader_result_t> results(opt.readers);
+	std::vector<std::thread> readers;
+	for (unsigned r = 0; r < opt.readers; r++) {
+		readers.emplace_back([&, r]() {
+			reader_result_t& res = results[r];
+			uint32_t last = 0;
+			T p;
+			// Check done before the last read so every reader sees the final write
+			while (true) {
+				bool stop = done.load(std::memory_order_acquire);
+				uint32_t n = lock.read(p);
+				if (n != 0) {
+					res.reads++;
+					if (!consistent(p)) res.torn++;
+					else if (payload_n(p) != n) res.mismatched++;
+					if (n < last) res.backwards++;
+					last = n;
+				}
+				if (stop) break;
+			}
+		});
+	}
+
+	T p;
+	for (uint32_t n = 1; n <= opt.writes; n++) {
+		fill(p, n);
+		lock.write(p);
+	}
+	done.store(true, std::memory_order_release);
+	for (std::thread& t : readers) t.join();
+
+	reader_result_t total;
+	for (const reader_result_t& r : results) {
+		total.reads += r.reads;
+		total.torn += r.torn;
+		total.mismatched += r.mismatched;
+		total.backwards += r.backwards;
+	}
+	bool ok = total.torn == 0 && total.mismatched == 0 && total.backwards == 0 && lock.count() == opt.writes;
+	printf("%s: %zu bytes, %u writes, %u readers, %llu reads, %llu torn, %llu mismatched, %llu backwards, %s\n",
+		name, sizeof(T), opt.writes, opt.readers, (unsigned long long)total.reads, (unsigned long long)total.torn,
+		(unsigned long long)total.mismatched, (unsigned long long)total.backwards, ok ? "ok" : "FAILED");
+	return ok;
+}
+
+int main(int argc, char** argv) {
+	options_t opt;
+	for (int i = 1; i < argc; i++) {
+		std::string a = argv[i];
+		bool has_val = i + 1 < argc;
+		if (a == "--readers" && has_val) opt.readers = atoi(argv[++i]);
+		else if (a == "--writes" && has_val) opt.writes = strtoul(argv[++i], nullptr, 10);
+		else {
+			fprintf(stderr, "usage: %s [--readers N] [--writes N]\n", argv[0]);
+			return 1;
+		}
+	}
+	if (opt.readers == 0) opt.readers = std::thread::hardware_concurrency() > 2 ? std::thread::hardware_concurrency() - 1 : 2;
+
+	bool ok = run<word_payload_t>("word payload", opt);
+	ok = run<byte_payload_t>("byte payload", opt) && ok;
+	return ok ? 0 : 1;
+}
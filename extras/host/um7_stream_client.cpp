@@ -0,0 +1,158 @@
+/*
+
+Linux client for the binary frame stream of examples/Stream_UM7s.
+See um7_stream_client.h.
+
+*/
+
+#include "um7_stream_client.h"
+
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <unistd.h>
+
+UM7StreamClient::UM7StreamClient()
+	: fd_(-1), running_(false), block_len_(0), have_seq_(false), last_seq_(0),
+	  frames_(0), dropped_(0), crc_errors_(0), overflows_(0) {}
+
+UM7StreamClient::~UM7StreamClient() {
+	stop();
+}
+
+bool UM7StreamClient::open(const std::string& device) {
+	fd_ = ::open(device.c_str(), O_RDONLY | O_NOCTTY);
+	if (fd_ < 0) {
+		set_error(device + ": " + strerror(errno));
+		return false;
+	}
+	// Raw mode. The baud rate is irrelevant for USB CDC devices like the Teensy,
+	// but set it for real UARTs.
+	termios tio;
+	if (tcgetattr(fd_, &tio) == 0) {
+		cfmakeraw(&tio);
+		cfsetispeed(&tio, B115200);
+		cfsetospeed(&tio, B115200);
+		tio.c_cc[VMIN] = 0;
+		tio.c_cc[VTIME] = 0;
+		tcsetattr(fd_, TCSANOW, &tio);
+	}
+	return true;
+}
+
+bool UM7StreamClient::start(callback_t callback) {
+	if (fd_ < 0) {
+		set_error("device not open");
+		return false;
+	}
+	callback_ = callback;
+	running_ = true;
+	dispatcher_ = std::thread(&UM7StreamClient::dispatch_loop, this);
+	reader_ = std::thread(&UM7StreamClient::read_loop, this);
+	return true;
+}
+
+void UM7StreamClient::stop() {
+	running_ = false;
+	if (reader_.joinable()) reader_.join();
+	if (dispatcher_.joinable()) dispatcher_.join();
+	if (fd_ >= 0) {
+		::close(fd_);
+		fd_ = -1;
+	}
+}
+
+std::string UM7StreamClient::error() const {
+	std::lock_guard<std::mutex> lock(error_mutex_);
+	return error_;
+}
+
+void UM7StreamClient::set_error(const std::string& error) {
+	std::lock_guard<std::mutex> lock(error_mutex_);
+	error_ = error;
+}
+
+um7_stream_stats_t UM7StreamClient::stats() const {
+	um7_stream_stats_t s;
+	s.frames = frames_;
+	s.dropped = dropped_;
+	s.crc_errors = crc_errors_;
+	s.overflows = overflows_;
+	return s;
+}
+
+void UM7StreamClient::feed(const uint8_t* data, size_t n) {
+	for (size_t i = 0; i < n; i++) {
+		if (data[i] == UM7_FRAME_DELIM) {
+			if (block_len_ > 0) handle_block(block_, block_len_);
+			block_len_ = 0;
+		} else if (block_len_ < sizeof(block_)) {
+			block_[block_len_++] = data[i];
+		} else {
+			// Longer than any valid frame, a delimiter was lost. Drop until the next one.
+			block_len_ = sizeof(block_) + 1;
+		}
+	}
+}
+
+void UM7StreamClient::handle_block(const uint8_t* block, size_t n) {
+	um7_frame_t frame;
+	if (n > sizeof(block_) || !um7_frame_decode(block, n, frame)) {
+		crc_errors_++;
+		return;
+	}
+	if (have_seq_) {
+		uint16_t gap = (uint16_t)(frame.seq - last_seq_ - 1);
+		dropped_ += gap;
+	}
+	have_seq_ = true;
+	last_seq_ = frame.seq;
+	frames_++;
+
+	if (!queue_.push(frame)) overflows_++;
+}
+
+void UM7StreamClient::read_loop() {
+	uint8_t buf[4096];
+	pollfd pfd;
+	pfd.fd = fd_;
+	pfd.events = POLLIN;
+
+	while (running_) {
+		// Wake up regularly so stop() doesn't wait on a silent device
+		int r = poll(&pfd, 1, 100);
+		if (r < 0 && errno != EINTR) {
+			set_error(std::string("poll: ") + strerror(errno));
+			break;
+		}
+		if (r <= 0) continue;
+		// An unplugged device reports POLLHUP (or POLLERR) forever, and a readable fd that
+		// returns no bytes is the same end of stream
+		ssize_t n = (pfd.revents & POLLIN) ? ::read(fd_, buf, sizeof(buf)) : 0;
+		if (n < 0 && errno != EAGAIN && errno != EINTR) {
+			set_error(std::string("read: ") + strerror(errno));
+			break;
+		}
+		if (n > 0) {
+			feed(buf, (size_t)n);
+		} else if (n == 0 || (pfd.revents & (POLLHUP | POLLERR | POLLNVAL))) {
+			set_error("device disconnected");
+			break;
+		}
+	}
+	running_ = false;
+}
+
+void UM7StreamClient::dispatch_loop() {
+	um7_frame_t frame;
+	while (running_ || queue_.size() > 0) {
+		if (queue_.pop(frame)) {
+			callback_(frame);
+		} else {
+			std::this_thread::sleep_for(std::chrono::microseconds(200));
+		}
+	}
+}
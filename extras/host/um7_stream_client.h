@@ -0,0 +1,88 @@
+/*
+
+Linux client for the binary frame stream of examples/Stream_UM7s.
+
+A reader thread pulls bytes from the serial device, splits them on the COBS
+delimiter and decodes frames into a lock-free queue. A dispatch thread pops
+the queue and hands each sample to the user callback, so a slow callback
+never stalls the serial reads (frames are dropped and counted instead).
+
+Sequence gaps, CRC failures and malformed frames are counted separately in
+stats(). Unplugging the device stops both threads, running() turns false and
+error() says why.
+
+*/
+
+#ifndef UM7_STREAM_CLIENT_H
+#define UM7_STREAM_CLIENT_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "UM7Frame.h"
+#include "spsc_queue.h"
+
+struct um7_stream_stats_t {
+	uint64_t frames;     // frames decoded successfully
+	uint64_t dropped;    // frames missing according to the sequence number
+	uint64_t crc_errors; // frames failing COBS, length or CRC checks
+	uint64_t overflows;  // frames discarded because the callback fell behind
+};
+
+class UM7StreamClient {
+
+public:
+
+	typedef std::function<void(const um7_frame_t&)> callback_t;
+
+	UM7StreamClient();
+	~UM7StreamClient();
+
+	// Opens the serial device in raw mode. Returns false and sets error() on failure.
+	bool open(const std::string& device);
+	// Starts the reader and dispatch threads
+	bool start(callback_t callback);
+	// Stops both threads and closes the device
+	void stop();
+
+	// False once stop() was called or the device was disconnected
+	bool running() const { return running_; }
+
+	um7_stream_stats_t stats() const;
+	// Set by open()/start() and by the reader thread, safe to call while it runs
+	std::string error() const;
+
+	// Feeds raw bytes through the frame decoder, used by the reader thread
+	// and for replaying captured streams
+	void feed(const uint8_t* data, size_t n);
+
+private:
+
+	void read_loop();
+	void dispatch_loop();
+	void handle_block(const uint8_t* block, size_t n);
+	void set_error(const std::string& error);
+
+	int fd_;
+	mutable std::mutex error_mutex_;
+	std::string error_;
+	callback_t callback_;
+	std::thread reader_, dispatcher_;
+	std::atomic<bool> running_;
+
+	SpscQueue<um7_frame_t, 1024> queue_;
+
+	// Decoder state, only touched by the reader thread
+	uint8_t block_[UM7_FRAME_MAX_ENCODED];
+	size_t block_len_;
+	bool have_seq_;
+	uint16_t last_seq_;
+
+	std::atomic<uint64_t> frames_, dropped_, crc_errors_, overflows_;
+};
+
+#endif
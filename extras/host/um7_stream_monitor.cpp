@@ -0,0 +1,79 @@
+/*
+
+Live monitor for examples/Stream_UM7s.
+
+Prints every decoded sample as a csv line on stdout and the frame statistics
+on stderr once per second. Columns are named like the SD logger csv (TRANSFER #,
+TIME, G1X ... YAW3, no FSR columns), so um7_log_csv.h and the tools using it
+load the capture. SEQ is the frame sequence number.
+
+Exits on Ctrl-C or when the device is unplugged.
+
+Build:
+  g++ -O2 -std=c++17 -pthread -I../.. um7_stream_monitor.cpp um7_stream_client.cpp -o um7_stream_monitor
+
+Usage:
+  ./um7_stream_monitor /dev/ttyACM0 > session.csv
+
+*/
+
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <thread>
+
+#include "um7_stream_client.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int) {
+	stop_requested = 1;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s <serial device>\n", argv[0]);
+		return 1;
+	}
+	signal(SIGINT, on_signal);
+
+	UM7StreamClient client;
+	if (!client.open(argv[1])) {
+		fprintf(stderr, "%s\n", client.error().c_str());
+		return 1;
+	}
+
+	bool header = false;
+	uint32_t nr = 0;
+	client.start([&header, &nr](const um7_frame_t& f) {
+		if (!header) {
+			printf("TRANSFER #,SEQ,TIME");
+			for (int i = 1; i <= f.n_imus; i++) {
+				printf(",G%dX,G%dY,G%dZ,A%dX,A%dY,A%dZ,ROLL%d,PITCH%d,YAW%d", i, i, i, i, i, i, i, i, i);
+			}
+			printf("\n");
+			header = true;
+		}
+		printf("%u,%u,%u", nr++, f.seq, f.t);
+		for (int i = 0; i < f.n_imus; i++) {
+			const um7_frame_imu_t& m = f.imu[i];
+			printf(",%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%d,%d,%d",
+				m.gx, m.gy, m.gz, m.ax, m.ay, m.az, m.roll, m.pitch, m.yaw);
+		}
+		printf("\n");
+	});
+
+	while (!stop_requested && client.running()) {
+		std::this_thread::sleep_for(std::chrono::seconds(1));
+		um7_stream_stats_t s = client.stats();
+		fprintf(stderr, "frames: %llu  dropped: %llu  crc errors: %llu  overflows: %llu\n",
+			(unsigned long long)s.frames, (unsigned long long)s.dropped,
+			(unsigned long long)s.crc_errors, (unsigned long long)s.overflows);
+	}
+	client.stop();
+	if (!stop_requested) {
+		fprintf(stderr, "%s\n", client.error().c_str());
+		return 1;
+	}
+	return 0;
+}
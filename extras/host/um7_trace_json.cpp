@@ -0,0 +1,187 @@
+/*
+
+Converts SPI trace dumps (UM7Trace.h, 'd' in Teensy_DEDICATED_SPI_UM7) to
+Chrome trace JSON, for chrome://tracing or https://ui.perfetto.dev.
+
+Input is a capture of the serial output, only the "TRACE" lines are read.
+Each input file becomes one process in the trace, each UM7 (CS pin) one
+thread, plus "logRecord" and "SD write" threads for the logging loop spans.
+An SPI transaction is drawn as a slice from before SPI.beginTransaction to
+after SPI.endTransaction, with the CS low window nested inside it.
+
+micros() wraps after ~71 minutes, timestamps are unwrapped across the dump.
+
+Build:
+  g++ -O2 -std=c++17 um7_trace_json.cpp -o um7_trace_json
+
+Usage:
+  ./um7_trace_json capture1.txt capture2.txt ... > trace.json
+
+Prints the time spent per event kind to stderr.
+
+*/
+
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+// Same values as UM7Trace.h
+enum { TRACE_READ, TRACE_WRITE, TRACE_RECORD, TRACE_SD_WRITE, TRACE_USER };
+
+// Threads for the spans that aren't on a UM7
+#define TID_RECORD 1000
+#define TID_SD 1001
+#define TID_USER 1002
+
+struct trace_event_t {
+	int kind, id, address, bytes;
+	uint64_t start, cs_low, cs_high, end;
+};
+
+struct kind_total_t {
+	uint32_t count = 0;
+	uint64_t total_us = 0, max_us = 0;
+};
+
+// Data register names from MYUM7SPI.h, in address order from DREG_HEALTH
+static const char* DREG_NAMES[] = {
+	"HEALTH", "GYRO_RAW_XY", "GYRO_RAW_Z", "GYRO_RAW_TIME", "ACCEL_RAW_XY", "ACCEL_RAW_Z", "ACCEL_RAW_TIME",
+	"MAG_RAW_XY", "MAG_RAW_Z", "MAG_RAW_TIME", "TEMPERATURE", "TEMPERATURE_TIME",
+	"GYRO_PROC_X", "GYRO_PROC_Y", "GYRO_PROC_Z", "GYRO_PROC_TIME", "ACCEL_PROC_X", "ACCEL_PROC_Y", "ACCEL_PROC_Z",
+	"ACCEL_PROC_TIME", "MAG_PROC_X", "MAG_PROC_Y", "MAG_PROC_Z", "MAG_PROC_TIME",
+	"QUAT_AB", "QUAT_CD", "QUAT_TIME", "EULER_PHI_THETA", "EULER_PSI", "EULER_PHI_THETA_DOT", "EULER_PSI_DOT",
+	"EULER_TIME", "POSITION_N", "POSITION_E", "POSITION_UP", "POSITION_TIME", "VELOCITY_N", "VELOCITY_E",
+	"VELOCITY_UP", "VELOCITY_TIME"
+};
+#define DREG_FIRST 0x55
+
+static std::string register_name(int address) {
+	int i = address - DREG_FIRST;
+	if (i >= 0 && i < (int)(sizeof(DREG_NAMES) / sizeof(DREG_NAMES[0]))) return DREG_NAMES[i];
+	char name[16];
+	snprintf(name, sizeof(name), "0x%02X", address);
+	return name;
+}
+
+// Reads the TRACE lines of a capture, unwrapping each time against the end of the previous event
+static bool load_trace(const std::string& path, std::vector<trace_event_t>& events, std::string& err) {
+	FILE* f = fopen(path.c_str(), "rb");
+	if (!f) {
+		err = path + ": cannot open";
+		return false;
+	}
+	char line[256];
+	uint64_t last = 0;
+	bool first = true;
+	while (fgets(line, sizeof(line), f)) {
+		unsigned v[8];
+		if (sscanf(line, "TRACE,%u,%u,%u,%u,%u,%u,%u,%u", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7]) != 8) {
+			continue;
+		}
+		if (first) {
+			last = v[7];
+			first = false;
+		}
+		uint64_t t[4];
+		for (int k = 0; k < 4; k++) t[k] = last + (int32_t)(v[4 + k] - (uint32_t)last);
+		trace_event_t e = { (int)v[0], (int)v[1], (int)v[2], (int)v[3], t[0], t[1], t[2], t[3] };
+		events.push_back(e);
+		last = t[3];
+	}
+	fclose(f);
+	if (events.empty()) {
+		err = path + ": no TRACE lines";
+		return false;
+	}
+	return true;
+}
+
+static void print_slice(bool& comma, int pid, int tid, const std::string& name, const char* cat, uint64_t ts,
+	uint64_t dur, const std::string& args) {
+	printf("%s\n{\"name\":\"%s\",\"cat\":\"%s\",\"ph\":\"X\",\"pid\":%d,\"tid\":%d,\"ts\":%" PRIu64 ",\"dur\":%" PRIu64,
+		comma ? "," : "", name.c_str(), cat, pid, tid, ts, dur);
+	if (!args.empty()) printf(",\"args\":{%s}", args.c_str());
+	printf("}");
+	comma = true;
+}
+
+static void print_name(bool& comma, int pid, int tid, const char* what, const std::string& name) {
+	printf("%s\n{\"name\":\"%s\",\"ph\":\"M\",\"pid\":%d,\"tid\":%d,\"args\":{\"name\":\"%s\"}}",
+		comma ? "," : "", what, pid, tid, name.c_str());
+	comma = true;
+}
+
+int main(int argc, char** argv) {
+	if (argc < 2) {
+		fprintf(stderr, "usage: %s capture.txt ... > trace.json\n", argv[0]);
+		return 1;
+	}
+	static const char* KIND_NAMES[] = { "read", "write", "logRecord", "SD write", "user" };
+
+	printf("{\"traceEvents\":[");
+	bool comma = false;
+	int status = 0;
+	for (int a = 1; a < argc; a++) {
+		std::string path = argv[a], err;
+		std::vector<trace_event_t> events;
+		if (!load_trace(path, events, err)) {
+			fprintf(stderr, "%s\n", err.c_str());
+			status = 1;
+			continue;
+		}
+		int pid = a;
+		std::string base = path.substr(path.find_last_of('/') + 1);
+		print_name(comma, pid, 0, "process_name", base);
+
+		std::map<int, bool> named;
+		kind_total_t totals[5];
+		for (const trace_event_t& e : events) {
+			int kind = e.kind >= 0 && e.kind <= TRACE_USER ? e.kind : TRACE_USER;
+			uint64_t dur = e.end - e.start;
+			kind_total_t& k = totals[kind];
+			k.count++;
+			k.total_us += dur;
+			if (dur > k.max_us) k.max_us = dur;
+
+			char args[160];
+			if (kind == TRACE_READ || kind == TRACE_WRITE) {
+				int tid = e.id;
+				if (!named[tid]) {
+					print_name(comma, pid, tid, "thread_name", "UM7 cs " + std::to_string(e.id));
+					named[tid] = true;
+				}
+				// Setup is beginTransaction to CS low, teardown CS high to the end of endTransaction.
+				// MYUM7SPI.cpp waits delayMicroseconds(5) after every byte, that part of the CS window is delay_us.
+				snprintf(args, sizeof(args), "\"address\":\"0x%02X\",\"bytes\":%d,\"setup_us\":%" PRIu64 ",\"teardown_us\":%" PRIu64
+					",\"delay_us\":%d", e.address, e.bytes, e.cs_low - e.start, e.end - e.cs_high, e.bytes * 5);
+				print_slice(comma, pid, tid, std::string(KIND_NAMES[kind]) + " " + register_name(e.address), "spi",
+					e.start, dur, args);
+				print_slice(comma, pid, tid, "CS", "spi", e.cs_low, e.cs_high - e.cs_low, "");
+			} else {
+				int tid = kind == TRACE_RECORD ? TID_RECORD : kind == TRACE_SD_WRITE ? TID_SD : TID_USER + e.id;
+				if (!named[tid]) {
+					std::string name = KIND_NAMES[kind];
+					if (kind == TRACE_USER) name += " " + std::to_string(e.id);
+					print_name(comma, pid, tid, "thread_name", name);
+					named[tid] = true;
+				}
+				snprintf(args, sizeof(args), "\"bytes\":%d", e.bytes);
+				print_slice(comma, pid, tid, KIND_NAMES[kind], "logger", e.start, dur, args);
+			}
+		}
+
+		fprintf(stderr, "%s: %zu events over %.3f ms\n", base.c_str(), events.size(),
+			(events.back().end - events.front().start) / 1000.0);
+		for (int k = 0; k < 5; k++) {
+			if (!totals[k].count) continue;
+			fprintf(stderr, "  %-10s %8u x, total %10" PRIu64 " us, mean %8.1f us, max %6" PRIu64 " us\n", KIND_NAMES[k],
+				totals[k].count, totals[k].total_us, (double)totals[k].total_us / totals[k].count, totals[k].max_us);
+		}
+	}
+	printf("\n]}\n");
+	return status;
+}